@@ -182,13 +182,25 @@ std::shared_ptr<utils::MessageQueue> JscEngine::messageQueue() { return messageQ
 void JscEngine::gc() {
   if (isDestroying()) return;
   EngineScope engineScope(this);
+  recordGcBegin();
+  auto start = std::chrono::steady_clock::now();
   JSGarbageCollect(context_);
+  recordGcEnd(std::chrono::steady_clock::now() - start);
 }
 
-void JscEngine::adjustAssociatedMemory(int64_t /*count*/) {
+void JscEngine::adjustAssociatedMemory(int64_t count) {
   if (isDestroying()) return;
   // JSC have implemented this method
   // but not exported to public header...
+  recordAssociatedMemory(count);
+}
+
+EngineStats JscEngine::getStats() {
+  EngineScope engineScope(this);
+  auto stats = ScriptEngine::getStats();
+  stats.globalCount = globalWeakBookkeeping_.globalCount();
+  stats.weakCount = globalWeakBookkeeping_.weakCount();
+  return stats;
 }
 
 size_t JscEngine::keepReference(const Local<Value>& ref) {
@@ -93,6 +93,8 @@ class JscEngine : public ::script::ScriptEngine {
 
   void adjustAssociatedMemory(int64_t count) override;
 
+  EngineStats getStats() override;
+
   ScriptLanguage getLanguageType() override;
 
   std::string getEngineVersion() override;
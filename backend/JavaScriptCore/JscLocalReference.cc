@@ -477,6 +477,29 @@ void Local<Array>::set(size_t index, const script::Local<script::Value>& value)
 
 void Local<Array>::add(const script::Local<script::Value>& value) const { set(size(), value); }
 
+void Local<Array>::getRange(size_t start, size_t count, Local<Value>* out) const {
+  auto context = jsc_backend::currentEngineContextChecked();
+
+  for (size_t i = 0; i < count; ++i) {
+    JSValueRef jscException = nullptr;
+    Local<Value> ret(JSObjectGetPropertyAtIndex(context, val_, static_cast<unsigned>(start + i),
+                                                &jscException));
+    jsc_backend::JscEngine::checkException(jscException);
+    out[i] = std::move(ret);
+  }
+}
+
+void Local<Array>::setRange(size_t start, size_t count, const Local<Value>* values) const {
+  auto context = jsc_backend::currentEngineContextChecked();
+
+  for (size_t i = 0; i < count; ++i) {
+    JSValueRef jscException = nullptr;
+    JSObjectSetPropertyAtIndex(context, val_, static_cast<unsigned>(start + i),
+                               jsc_backend::JscEngine::toJsc(context, values[i]), &jscException);
+    jsc_backend::JscEngine::checkException(jscException);
+  }
+}
+
 void Local<Array>::clear() const {
   JSValueRef jscException = nullptr;
 
@@ -591,4 +614,8 @@ void Local<ByteBuffer>::commit() const {}
 
 void Local<ByteBuffer>::sync() const {}
 
+void Local<ByteBuffer>::commit(size_t, size_t) const {}
+
+void Local<ByteBuffer>::sync(size_t, size_t) const {}
+
 }  // namespace script
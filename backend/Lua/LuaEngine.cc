@@ -16,6 +16,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <utility>
@@ -35,8 +36,25 @@ namespace script::lua_backend {
 
 namespace {
 
-lua_State* newCommonLua() {
-  auto lua = luaL_newstate();
+lua_State* newCommonLua(lua_Alloc alloc, void* ud) {
+  auto lua = lua_newstate(alloc, ud);
+#ifdef SCRIPTX_LUA_LUAJIT
+  if (!lua) {
+    // x64 LuaJIT without GC64 only works with its own allocator,
+    // which is wrapped by the LuaEngine constructor instead.
+    lua = luaL_newstate();
+  }
+#endif
+  if (!lua) {
+    throw std::bad_alloc();
+  }
+  // the same as luaL_newstate does
+  lua_atpanic(lua, [](lua_State* lua) -> int {
+    auto message = lua_tostring(lua, -1);
+    Logger() << "PANIC: unprotected error in call to Lua API (" << (message ? message : "")
+             << ")";
+    return 0;
+  });
   luaL_openlibs(lua);
   return lua;
 }
@@ -69,15 +87,21 @@ const void* const LuaEngine::kLuaWeakRegistryToken_ =
 
 LuaEngine::LuaEngine(std::shared_ptr<::script::utils::MessageQueue> queue,
                      const std::function<lua_State*()>& luaStateFactory,
-                     std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate)
-    : messageQueue_(queue ? std::move(queue) : std::make_shared<utils::MessageQueue>()),
+                     std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate,
+                     ThreadMode threadMode)
+    : lock_(threadMode == ThreadMode::kSingleThread),
+      messageQueue_(queue ? std::move(queue) : std::make_shared<utils::MessageQueue>()),
       byteBufferDelegate_(byteBufferDelegate ? std::move(byteBufferDelegate)
                                              : std::make_unique<LuaByteBufferImpl>()) {
-  if (luaStateFactory) {
-    lua_ = luaStateFactory();
-    assert(lua_);
-  } else {
-    lua_ = newCommonLua();
+  // allocate from pool_ if not from factory
+  lua_ = luaStateFactory ? luaStateFactory() : newCommonLua(limitedAlloc, this);
+  assert(lua_);
+  if (lua_getallocf(lua_, nullptr) != limitedAlloc) {
+    // wrap the allocator for accounting, memory allocated so far is estimated
+    baseAlloc_ = lua_getallocf(lua_, &baseAllocData_);
+    heapUsed_ = static_cast<size_t>(lua_gc(lua_, LUA_GCCOUNT, 0)) * 1024 +
+                static_cast<size_t>(lua_gc(lua_, LUA_GCCOUNTB, 0));
+    lua_setallocf(lua_, limitedAlloc, this);
   }
 
   {
@@ -109,18 +133,70 @@ void LuaEngine::destroy() {
 
 bool lua_backend::LuaEngine::isDestroying() const { return isDestroying_; }
 
-void LuaEngine::initGlobalRegistry() {
-  lua_getglobal(lua_, kLuaGlobalEnvName);
-  auto global = lua_gettop(lua_);
+void* LuaEngine::limitedAlloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+  auto engine = static_cast<LuaEngine*>(ud);
+  // when ptr is null, osize is the type of object being allocated
+  auto oldSize = ptr ? osize : 0;
+
+  if (nsize > oldSize && engine->heapLimit_ != 0) {
+    auto used = engine->heapUsed_ + (nsize - oldSize);
+    if (used > engine->heapLimit_) {
+      auto newLimit = engine->nearHeapLimit(engine->heapLimit_, engine->heapUsed_);
+      if (newLimit != 0) {
+        engine->heapLimit_ = newLimit;
+      }
+      if (used > engine->heapLimit_) {
+        // lua runs an emergency gc and retries, or raises a memory error
+        return nullptr;
+      }
+    }
+  }
 
-  luaStackScope(lua_, [this, global]() {
-    // global
-    lua_newtable(lua_);
-    lua_rawsetp(lua_, global, kLuaGlobalRegistryToken_);
-  });
+  auto ret = engine->baseAlloc_ ? engine->baseAlloc_(engine->baseAllocData_, ptr, osize, nsize)
+                                : engine->pool_.reallocate(ptr, oldSize, nsize);
+  if (ret || nsize == 0) {
+    engine->heapUsed_ = engine->heapUsed_ - oldSize + nsize;
+  }
+  return ret;
+}
+
+bool LuaEngine::setHeapLimit(size_t bytes) {
+  EngineScope scope(this);
+  heapLimit_ = bytes;
+  return true;
+}
 
-  luaStackScope(lua_, [this, global] {
-    // weak
+void LuaEngine::terminateHook(lua_State* lua, lua_Debug*) {
+  // raised again on next instruction, until unwound out of lua (see callFunction)
+  luaL_error(lua, "script execution terminated");
+}
+
+bool LuaEngine::terminateExecution() {
+#ifdef SCRIPTX_LUA_LUAJIT
+  // LuaJIT doesn't run count hooks inside compiled traces, and the JIT can't be flushed
+  // from another thread while a trace runs, a loop can't be interrupted reliably.
+  return false;
+#else
+  if (!terminating_.exchange(true)) {
+    savedHook_ = lua_gethook(lua_);
+    savedHookMask_ = lua_gethookmask(lua_);
+    savedHookCount_ = lua_gethookcount(lua_);
+  }
+  // lua_sethook is safe to be called asynchronously, the hook takes effect on next instruction
+  lua_sethook(lua_, terminateHook, LUA_MASKCOUNT, 1);
+  return true;
+#endif
+}
+
+void LuaEngine::cancelTerminateExecution() {
+  if (terminating_.exchange(false)) {
+    lua_sethook(lua_, savedHook_, savedHookMask_, savedHookCount_);
+  }
+}
+
+void LuaEngine::initGlobalRegistry() {
+  // Globals are luaL_ref in the registry, Weaks are in a weak valued table held by the registry.
+  luaStackScope(lua_, [this] {
     lua_newtable(lua_);
 
     luaStackScope(lua_, [this] {
@@ -135,74 +211,70 @@ void LuaEngine::initGlobalRegistry() {
       lua_setmetatable(lua_, -2);
     });
 
-    lua_rawsetp(lua_, global, kLuaWeakRegistryToken_);
+    weakTableRef_ = luaL_ref(lua_, LUA_REGISTRYINDEX);
   });
 }
 
 size_t LuaEngine::putGlobalOrWeakTable(const Local<Value>& localReference,
                                        const void* registryToken) {
-  size_t id = 0;
-  if (localReference.val_ != 0) {
-    StackFrameScope scope;
-    lua_getglobal(lua_, kLuaGlobalEnvName);
-    auto global = lua_gettop(lua_);
-    lua_rawgetp(lua_, global, registryToken);
-    auto globalTable = lua_gettop(lua_);
-
-    auto counter = globalIdCounter();
-
-    make<Local<Array>>(globalTable).set(counter, localReference);
-
-    // pop globalTable
-    lua_pop(this->lua_, 1);
-
-    id = counter;
-    if (registryToken == kLuaGlobalRegistryToken_) {
-      globalRefCount_++;
-    } else {
-      weakRefCount_++;
-    }
+  if (localReference.val_ == 0) return 0;
+
+  lua_backend::luaEnsureStack(lua_, 2);
+  if (registryToken == kLuaGlobalRegistryToken_) {
+    lua_pushvalue(lua_, localReference.val_);
+    // LUA_REFNIL for nil, 0 is left for an empty Global
+    auto ref = luaL_ref(lua_, LUA_REGISTRYINDEX);
+    globalRefCount_++;
+    return static_cast<size_t>(ref - LUA_NOREF);
+  }
+
+  // not luaL_ref, it may hand out the slot of a collected value which is still referenced
+  size_t id;
+  if (!freeWeakIds_.empty()) {
+    id = freeWeakIds_.back();
+    freeWeakIds_.pop_back();
+  } else {
+    id = ++weakIdCounter_;
   }
+  lua_rawgeti(lua_, LUA_REGISTRYINDEX, weakTableRef_);
+  lua_pushvalue(lua_, localReference.val_);
+  lua_rawseti(lua_, -2, static_cast<lua_Integer>(id));
+  lua_pop(lua_, 1);
+  weakRefCount_++;
   return id;
 }
 
 void LuaEngine::removeGlobalOrWeakTable(size_t id, const void* registryToken) {
-  StackFrameScope scope;
-  lua_getglobal(lua_, kLuaGlobalEnvName);
-  auto global = lua_gettop(lua_);
-  lua_rawgetp(lua_, global, registryToken);
-  auto globalTable = lua_gettop(lua_);
-
-  make<Local<Array>>(globalTable).set(id, {});
-
-  // pop globalTable
-  lua_pop(this->lua_, 1);
-
   if (registryToken == kLuaGlobalRegistryToken_) {
+    luaL_unref(lua_, LUA_REGISTRYINDEX, static_cast<int>(id) + LUA_NOREF);
     globalRefCount_--;
-  } else {
-    weakRefCount_--;
+    return;
   }
+
+  lua_backend::luaEnsureStack(lua_, 2);
+  lua_rawgeti(lua_, LUA_REGISTRYINDEX, weakTableRef_);
+  lua_pushnil(lua_);
+  lua_rawseti(lua_, -2, static_cast<lua_Integer>(id));
+  lua_pop(lua_, 1);
+  freeWeakIds_.push_back(id);
+  weakRefCount_--;
 }
 
 Local<Value> LuaEngine::getGlobalOrWeakTable(size_t index, const void* registryToken) const {
   if (index == 0) return {};
 
-  StackFrameScope stack;
+  if (registryToken == kLuaGlobalRegistryToken_) {
+    lua_backend::luaEnsureStack(lua_, 1);
+    lua_rawgeti(lua_, LUA_REGISTRYINDEX, static_cast<int>(index) + LUA_NOREF);
+    return Local<Value>{lua_gettop(lua_)};
+  }
 
   lua_backend::luaEnsureStack(lua_, 2);
-  lua_getglobal(lua_, kLuaGlobalEnvName);
-  auto global = lua_gettop(lua_);
-  lua_rawgetp(lua_, global, registryToken);
-  auto globalTable = lua_gettop(lua_);
-
-  return stack.returnValue(make<Local<Array>>(globalTable).get(index));
-}
-
-size_t LuaEngine::globalIdCounter() {
-  while (++globalIdCounter_ == 0) {
-  }
-  return globalIdCounter_;
+  lua_rawgeti(lua_, LUA_REGISTRYINDEX, weakTableRef_);
+  lua_rawgeti(lua_, -1, static_cast<lua_Integer>(index));
+  // replace the weak table with the value
+  lua_replace(lua_, -2);
+  return Local<Value>{lua_gettop(lua_)};
 }
 
 Local<Value> LuaEngine::get(const Local<String>& key) {
@@ -577,16 +649,36 @@ void LuaEngine::pushInstanceFunction(const void* data,
 
 std::shared_ptr<utils::MessageQueue> LuaEngine::messageQueue() { return messageQueue_; }
 
-void LuaEngine::gc() { lua_gc(lua_, LUA_GCCOLLECT, 0); }
-
-size_t LuaEngine::getHeapSize() {
-  return lua_gc(lua_, LUA_GCCOUNT, 0) * 1024;  // NOLINT
+void LuaEngine::gc() {
+  recordGcBegin();
+  auto start = std::chrono::steady_clock::now();
+  lua_gc(lua_, LUA_GCCOLLECT, 0);
+  recordGcEnd(std::chrono::steady_clock::now() - start);
 }
 
-void LuaEngine::adjustAssociatedMemory(int64_t count) {}
+size_t LuaEngine::getHeapSize() { return heapUsed_; }
+
+void LuaEngine::adjustAssociatedMemory(int64_t count) { recordAssociatedMemory(count); }
+
+EngineStats LuaEngine::getStats() {
+  EngineScope scope(this);
+  auto stats = ScriptEngine::getStats();
+  if (!baseAlloc_) {
+    stats.totalHeapSize = (std::max)(stats.usedHeapSize, pool_.reservedBytes());
+  }
+  stats.globalCount = globalWeakBookkeeping_.globalCount();
+  stats.weakCount = globalWeakBookkeeping_.weakCount();
+  return stats;
+}
 
 ScriptLanguage LuaEngine::getLanguageType() { return ScriptLanguage::kLua; }
 
-std::string LuaEngine::getEngineVersion() { return LUA_RELEASE; }
+std::string LuaEngine::getEngineVersion() {
+#ifdef SCRIPTX_LUA_LUAJIT
+  return LUAJIT_VERSION;
+#else
+  return LUA_RELEASE;
+#endif
+}
 
 }  // namespace script::lua_backend
@@ -17,13 +17,21 @@
 
 #pragma once
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "../../src/Engine.h"
 #include "../../src/Exception.h"
 #include "../../src/Native.h"
 #include "../../src/utils/GlobalWeakBookkeeping.hpp"
 #include "../../src/utils/MessageQueue.h"
+#include "../../src/utils/SizeClassPool.h"
+#include "../../src/utils/ThreadAffinity.h"
 #include "LuaHelper.h"
 
+namespace script::test {
+class ScriptXTestFixture;
+}
+
 namespace script::lua_backend {
 
 class LuaByteBufferDelegate;
@@ -38,29 +46,55 @@ class LuaEngine : public ScriptEngine {
   static const void* const kLuaNativeInternalStorageToken_;
   static const void* const kLuaBuiltinDefinedClassMetaDataToken_;
 
+  // select the Global or Weak storage in putGlobalOrWeakTable and friends
   static const void* const kLuaGlobalRegistryToken_;
   static const void* const kLuaWeakRegistryToken_;
 
   static constexpr auto kIsInstanceBuiltInFunctionName = "isInstance";
   static constexpr auto kMetaTableBuiltInInstanceFunctions = "instanceFunction";
 
-  std::mutex lock_;
+  // no-op in ThreadMode::kSingleThread
+  utils::AffinityMutex<std::mutex> lock_;
   std::shared_ptr<::script::utils::MessageQueue> messageQueue_;
-  size_t globalIdCounter_ = 1;
   std::unordered_map<const internal::ClassDefineState*, Global<Object>> nativeDefineRegistry_;
   ::script::internal::GlobalWeakBookkeeping globalWeakBookkeeping_;
   std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate_;
 
   size_t globalRefCount_ = 0;
   size_t weakRefCount_ = 0;
+  // registry ref of the weak valued table, and the ids freed from it for reuse
+  int weakTableRef_ = LUA_NOREF;
+  size_t weakIdCounter_ = 0;
+  std::vector<size_t> freeWeakIds_;
   bool isDestroying_ = false;
 
   lua_State* lua_ = nullptr;
 
+  // limitedAlloc allocates from pool_, or the lua_Alloc of a lua_State from factory
+  // (or LuaJIT's own allocator, when it refuses a custom one)
+  utils::SizeClassPool pool_;
+  lua_Alloc baseAlloc_ = nullptr;
+  void* baseAllocData_ = nullptr;
+  // bytes requested by lua
+  size_t heapUsed_ = 0;
+  size_t heapLimit_ = 0;
+
+#ifdef SCRIPTX_LUA_LUAJIT
+  // declarations passed to ffi.cdef, see lua_interop::ffiDefine
+  std::unordered_set<std::string> ffiDefinitions_;
+#endif
+
+  // see terminateExecution, the hook replaced by terminateHook is restored on cancel
+  std::atomic_bool terminating_{false};
+  lua_Hook savedHook_ = nullptr;
+  int savedHookMask_ = 0;
+  int savedHookCount_ = 0;
+
  public:
   explicit LuaEngine(std::shared_ptr<::script::utils::MessageQueue> queue = {},
                      const std::function<lua_State*()>& luaStateFactory = {},
-                     std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate = {});
+                     std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate = {},
+                     ThreadMode threadMode = ThreadMode::kMultiThread);
 
   SCRIPTX_DISALLOW_COPY_AND_MOVE(LuaEngine);
 
@@ -86,6 +120,14 @@ class LuaEngine : public ScriptEngine {
 
   void adjustAssociatedMemory(int64_t count) override;
 
+  EngineStats getStats() override;
+
+  bool setHeapLimit(size_t bytes) override;
+
+  bool terminateExecution() override;
+
+  void cancelTerminateExecution() override;
+
   ScriptLanguage getLanguageType() override;
 
   std::string getEngineVersion() override;
@@ -110,12 +152,14 @@ class LuaEngine : public ScriptEngine {
  private:
   void initGlobalRegistry();
 
+  static void* limitedAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+  static void terminateHook(lua_State* lua, lua_Debug* ar);
+
   Local<Value> get(const char* key);
 
   void set(const char* key, const Local<Value>& value);
 
-  size_t globalIdCounter();
-
   size_t putGlobalOrWeakTable(const Local<Value>& localReference, const void* registryToken);
 
   void removeGlobalOrWeakTable(size_t id, const void* registryToken);
@@ -225,6 +269,9 @@ class LuaEngine : public ScriptEngine {
 
   friend lua_State* currentLua();
 
+  friend Local<Value> callFunction(const Local<Value>& func, const Local<Value>& thiz,
+                                   size_t argsCount, const Local<Value>* begin);
+
   friend void pushValue(lua_State* lua, const Local<Value>& local);
 
   template <typename It>
@@ -238,6 +285,9 @@ class LuaEngine : public ScriptEngine {
   friend struct LuaBookKeepFetcher;
 
   friend struct ::script::lua_interop;
+
+  // UnitTest
+  friend class ::script::test::ScriptXTestFixture;
 };
 
 class LuaByteBufferDelegate {
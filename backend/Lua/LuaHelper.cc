@@ -50,7 +50,8 @@ int luaErrorMessageHandler(lua_State* L) {
 
 Local<Value> callFunction(const Local<Value>& func, const Local<Value>& thiz, size_t argsCount,
                           const Local<Value>* begin) {
-  auto lua = currentLua();
+  auto engine = currentEngine();
+  auto lua = engine->lua_;
 
   int base = lua_gettop(lua);
 
@@ -77,6 +78,12 @@ Local<Value> callFunction(const Local<Value>& func, const Local<Value>& thiz, si
 
   auto ret = lua_pcall(lua, nArgs, LUA_MULTRET, base);
 
+  lua_Debug ar;
+  if (engine->terminating_.load(std::memory_order_relaxed) && lua_getstack(lua, 0, &ar) == 0) {
+    // back to the outermost native caller, the termination is done
+    engine->cancelTerminateExecution();
+  }
+
   // remove the message handler
   lua_remove(lua, base);
 
@@ -167,7 +174,8 @@ void* getUserDataFromFinalizableUserData(lua_State* lua, int finalizableUserData
 
 void luaCopyTable(lua_State* lua, int from, int to) {
   luaStackScope(lua, [lua, from, to]() {
-    luaEnsureStack(lua, 2);
+    // key, value and the dup key
+    luaEnsureStack(lua, 3);
     lua_pushnil(lua);  // first key
     while (lua_next(lua, from) != 0) {
       // dup the key
@@ -192,4 +200,46 @@ Local<Object> luaNewObject(const Local<Value>& obj, size_t size, const Local<Val
   throw Exception("Object don't have constructor, ie. '__call' function in metatable");
 }
 
-}  // namespace script::lua_backend
\ No newline at end of file
+}  // namespace script::lua_backend
+#ifdef SCRIPTX_LUA_LUAJIT
+
+namespace script {
+
+namespace {
+
+// the ffi library is loaded (but not set as a global) by luaL_openlibs
+Local<Object> luaFfiModule() {
+  auto require = lua_backend::currentEngine()->get("require");
+  if (!require.isFunction()) {
+    throw Exception("require is not available");
+  }
+  return require.asFunction().call({}, String::newString("ffi")).asObject();
+}
+
+}  // namespace
+
+void lua_interop::ffiDefine(const std::string& declarations) {
+  auto engine = lua_backend::currentEngine();
+  if (engine->ffiDefinitions_.count(declarations) != 0) return;
+
+  // LuaJIT rejects redefinition of a struct, even the identical one
+  StackFrameScope stack;
+  luaFfiModule().get("cdef").asFunction().call({}, String::newString(declarations));
+  engine->ffiDefinitions_.insert(declarations);
+}
+
+Local<Value> lua_interop::ffiPointer(const char* ctype, void* pointer) {
+  StackFrameScope stack;
+  auto lua = currentEngineLua();
+  lua_backend::luaEnsureStack(lua, 1);
+  lua_pushlightuserdata(lua, pointer);
+  auto address = makeLocal<Value>(lua_gettop(lua));
+
+  auto cdata =
+      luaFfiModule().get("cast").asFunction().call({}, String::newString(ctype), address);
+  return stack.returnValue(cdata);
+}
+
+}  // namespace script
+
+#endif
@@ -23,6 +23,87 @@ SCRIPTX_BEGIN_INCLUDE_LIBRARY
 #include <lua.hpp>
 SCRIPTX_END_INCLUDE_LIBRARY
 
+// LuaJIT is detected from its headers, or required by the SCRIPTX_LUA_LUAJIT build option
+#if defined(LUAJIT_VERSION_NUM) && !defined(SCRIPTX_LUA_LUAJIT)
+#define SCRIPTX_LUA_LUAJIT
+#elif defined(SCRIPTX_LUA_LUAJIT) && !defined(LUAJIT_VERSION_NUM)
+#error "SCRIPTX_LUA_LUAJIT is set, but lua.hpp is not from LuaJIT"
+#endif
+
+#if LUA_VERSION_NUM < 502 && !defined(SCRIPTX_LUA_LUAJIT)
+#error "ScriptX Lua backend requires Lua 5.2+ or LuaJIT"
+#endif
+
+#ifndef LUA_OK
+#define LUA_OK 0
+#endif
+
+namespace script {
+
+// Lua 5.2/5.3 API used by the backend, implemented on top of LuaJIT (Lua 5.1 API).
+// declared in namespace script, so they take precedence over any global version.
+
+#if LUA_VERSION_NUM < 502
+
+#ifndef LUA_OPEQ
+#define LUA_OPEQ 0
+#endif
+
+inline int lua_absindex(lua_State* lua, int index) {
+  return index > 0 || index <= LUA_REGISTRYINDEX ? index : lua_gettop(lua) + index + 1;
+}
+
+inline int lua_rawgetp(lua_State* lua, int index, const void* p) {
+  index = lua_absindex(lua, index);
+  lua_pushlightuserdata(lua, const_cast<void*>(p));
+  lua_rawget(lua, index);
+  return lua_type(lua, -1);
+}
+
+inline void lua_rawsetp(lua_State* lua, int index, const void* p) {
+  index = lua_absindex(lua, index);
+  lua_pushlightuserdata(lua, const_cast<void*>(p));
+  lua_insert(lua, -2);
+  lua_rawset(lua, index);
+}
+
+inline lua_Integer luaL_len(lua_State* lua, int index) {
+  return static_cast<lua_Integer>(lua_objlen(lua, index));
+}
+
+// only LUA_OPEQ
+inline int lua_compare(lua_State* lua, int index1, int index2, int /*op*/) {
+  return lua_equal(lua, index1, index2);
+}
+
+// [-0, +1, e] needs 2 free slots
+inline const char* luaL_tolstring(lua_State* lua, int index, size_t* len) {
+  index = lua_absindex(lua, index);
+  lua_getglobal(lua, "tostring");
+  lua_pushvalue(lua, index);
+  lua_call(lua, 1, 1);
+  return lua_tolstring(lua, -1, len);
+}
+
+#endif
+
+#if LUA_VERSION_NUM < 503
+
+inline void lua_rotate(lua_State* lua, int index, int n) {
+  index = lua_absindex(lua, index);
+  for (; n > 0; --n) {
+    lua_insert(lua, index);
+  }
+  for (; n < 0; ++n) {
+    lua_pushvalue(lua, index);
+    lua_remove(lua, index);
+  }
+}
+
+#endif
+
+}  // namespace script
+
 namespace script::lua_backend {
 
 constexpr const char* kLuaGlobalEnvName = "_G";
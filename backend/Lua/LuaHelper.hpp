@@ -18,8 +18,13 @@
 #pragma once
 
 #include <cassert>
+#include <cmath>
+#include <limits>
 #include <optional>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include "../../src/Reference.h"
 #include "../../src/Scope.h"
 #include "LuaEngine.h"
@@ -106,6 +111,109 @@ inline void rethrowException(lua_State* lua) {
   throw exp;  // NOLINT
 }
 
+// [-0, +0, v]
+template <typename T>
+T luaToPrimitive(lua_State* lua, int index) {
+  if constexpr (std::is_same_v<T, bool>) {
+    if (lua_type(lua, index) != LUA_TBOOLEAN) {
+      luaL_error(lua, "Argument %d is not a boolean", index);
+    }
+    return lua_toboolean(lua, index) != 0;
+  } else {
+    if (lua_type(lua, index) != LUA_TNUMBER) {
+      luaL_error(lua, "Argument %d is not a number", index);
+    }
+    if constexpr (std::is_integral_v<T>) {
+      using Limits = std::numeric_limits<T>;
+#if LUA_VERSION_NUM >= 503
+      if (lua_isinteger(lua, index)) {
+        auto value = lua_tointeger(lua, index);
+        bool inRange;
+        if constexpr (std::is_signed_v<T>) {
+          inRange = value >= (Limits::min)() && value <= (Limits::max)();
+        } else {
+          inRange = value >= 0 && static_cast<std::make_unsigned_t<lua_Integer>>(value) <=
+                                      (Limits::max)();
+        }
+        if (!inRange) luaL_error(lua, "Argument %d is out of range", index);
+        return static_cast<T>(value);
+      }
+#endif
+      // casting a float not representable by T is undefined behavior
+      auto value = lua_tonumber(lua, index);
+      if (std::floor(value) != value) {
+        luaL_error(lua, "Argument %d is not an integer", index);
+      }
+      // [min, max + 1), both bounds are powers of 2 (or 0) and exact as lua_Number
+      auto lower = static_cast<lua_Number>((Limits::min)());
+      auto upper = static_cast<lua_Number>((Limits::max)() / 2 + 1) * 2;
+      if (!(value >= lower && value < upper)) {
+        luaL_error(lua, "Argument %d is out of range", index);
+      }
+      return static_cast<T>(value);
+    } else {
+      return static_cast<T>(lua_tonumber(lua, index));
+    }
+  }
+}
+
+// [-0, +1, -]
+template <typename T>
+void luaPushPrimitive(lua_State* lua, T value) {
+  if constexpr (std::is_same_v<T, bool>) {
+    lua_pushboolean(lua, value);
+  } else if constexpr (std::is_integral_v<T>) {
+    lua_pushinteger(lua, static_cast<lua_Integer>(value));
+  } else {
+    lua_pushnumber(lua, static_cast<lua_Number>(value));
+  }
+}
+
+/**
+ * the lua_CFunction of lua_interop::newPrimitiveFunction,
+ * upvalues: 1. the function pointer 2. the LuaEngine
+ */
+template <typename R, typename... Args>
+struct PrimitiveFunction {
+  static_assert((std::is_void_v<R> || std::is_arithmetic_v<R>) &&
+                    (std::is_arithmetic_v<Args> && ...),
+                "only arithmetic (including bool) parameters and return type are supported");
+
+  using Func = R (*)(Args...);
+
+  static int call(lua_State* lua) { return callImpl(lua, std::index_sequence_for<Args...>()); }
+
+ private:
+  template <size_t... index>
+  static int callImpl(lua_State* lua, std::index_sequence<index...>) {
+    constexpr auto kArgsCount = static_cast<int>(sizeof...(Args));
+    if (lua_gettop(lua) != kArgsCount) {
+      luaL_error(lua, "Argument count mismatch, expect:%d got:%d", kArgsCount, lua_gettop(lua));
+    }
+    auto func = reinterpret_cast<Func>(lua_touserdata(lua, lua_upvalueindex(1)));
+    auto engine = static_cast<LuaEngine*>(lua_touserdata(lua, lua_upvalueindex(2)));
+    // all arguments are converted before anything with a destructor is alive,
+    // luaL_error longjmps
+    std::tuple<Args...> args{luaToPrimitive<Args>(lua, static_cast<int>(index) + 1)...};
+
+    std::optional<std::string> exception;
+    try {
+      Tracer trace(engine, "nativeFunction");
+      if constexpr (std::is_void_v<R>) {
+        std::apply(func, args);
+        return 0;
+      } else {
+        luaPushPrimitive(lua, std::apply(func, args));
+        return 1;
+      }
+    } catch (const Exception& e) {
+      exception = e.message();
+    }
+    luaThrow(lua, exception);
+    return 0;
+  }
+};
+
 }  // namespace script::lua_backend
 
 namespace script {
@@ -144,6 +252,45 @@ struct lua_interop {
   using ArgumentsData = lua_backend::ArgumentsData;
 
   static ArgumentsData extractArguments(const Arguments& args) { return args.callbackInfo_; }
+
+  /**
+   * bind a function whose parameters and return type are all arithmetic (bool, integer, floating
+   * point, or a void return) as a specialized lua_CFunction. Arguments are read with
+   * lua_tointeger/lua_tonumber/lua_toboolean and the result is pushed directly, no Arguments
+   * or Local<Value> is created on a call.
+   *
+   * Behaves like Function::newFunction(func) with nothrow = false.
+   * A captureless lambda can be passed with a leading +, ie. newPrimitiveFunction(+[](int) {}).
+   */
+  template <typename R, typename... Args>
+  static Local<Function> newPrimitiveFunction(R (*func)(Args...)) {
+    auto engine = lua_backend::currentEngine();
+    auto lua = engine->lua_;
+    lua_backend::luaEnsureStack(lua, 2);
+    lua_pushlightuserdata(lua, reinterpret_cast<void*>(func));
+    lua_pushlightuserdata(lua, engine);
+    lua_pushcclosure(lua, &lua_backend::PrimitiveFunction<R, Args...>::call, 2);
+    return makeLocal<Function>(lua_gettop(lua));
+  }
+
+#ifdef SCRIPTX_LUA_LUAJIT
+  /**
+   * LuaJIT only: ffi.cdef the C declarations, each distinct string is defined once per engine.
+   * \code
+   * lua_interop::ffiDefine("typedef struct { double x, y, z; } Vec3;");
+   * \endcode
+   */
+  static void ffiDefine(const std::string& declarations);
+
+  /**
+   * LuaJIT only: wrap native memory as a FFI cdata pointer of ctype (ie. "Vec3*"),
+   * field access on it is compiled by the JIT into plain loads and stores.
+   *
+   * Useful to expose a plain-data member of a ScriptClass from a property getter.
+   * The cdata doesn't keep the memory alive, the owner must outlive it.
+   */
+  static Local<Value> ffiPointer(const char* ctype, void* pointer);
+#endif
 };
 
 }  // namespace script
@@ -243,7 +243,7 @@ Local<String> Local<Value>::describe() const {
   if (isNull()) return String::newString("nil");
 
   auto lua = lua_backend::currentLua();
-  lua_backend::luaEnsureStack(lua, 1);
+  lua_backend::luaEnsureStack(lua, 2);
 
   luaL_tolstring(lua, val_, nullptr);
 
@@ -340,8 +340,8 @@ std::vector<Local<String>> Local<Object>::getKeys() const {
 
   std::vector<Local<String>> ret;
 
-  auto len = static_cast<int>(luaL_len(lua, val_));
-  lua_backend::luaEnsureStack(lua, len + 1);
+  // each string key stays on the stack, room for lua_next is ensured as it grows
+  lua_backend::luaEnsureStack(lua, 3);
 
   lua_pushnil(lua);  // first key
   while (lua_next(lua, val_) != 0) {
@@ -349,13 +349,11 @@ std::vector<Local<String>> Local<Object>::getKeys() const {
     lua_pop(lua, 1);
 
     if (lua_type(lua, -1) == LUA_TSTRING) {
+      lua_backend::luaEnsureStack(lua, 3);
       // dup key, one for result, one for next iteration
       lua_pushvalue(lua, -1);
 
       ret.emplace_back(Local<String>(lua_absindex(lua, -2)));
-
-    } else {
-      continue;
     }
   }
 
@@ -410,6 +408,28 @@ void Local<Array>::set(size_t index, const script::Local<script::Value>& value)
 
 void Local<Array>::add(const script::Local<script::Value>& value) const { set(size(), value); }
 
+void Local<Array>::getRange(size_t start, size_t count, Local<Value>* out) const {
+  auto lua = lua_backend::currentLua();
+
+  lua_backend::luaEnsureStack(lua, static_cast<int>(count));
+  for (size_t i = 0; i < count; ++i) {
+    lua_rawgeti(lua, val_, static_cast<lua_Integer>(start + i + 1));
+    out[i] = Local<Value>{lua_gettop(lua)};
+  }
+}
+
+void Local<Array>::setRange(size_t start, size_t count, const Local<Value>* values) const {
+  auto lua = lua_backend::currentLua();
+
+  lua_backend::luaStackScope(lua, [this, lua, start, count, values]() {
+    lua_backend::luaEnsureStack(lua, 1);
+    for (size_t i = 0; i < count; ++i) {
+      lua_backend::pushValue(lua, values[i]);
+      lua_rawseti(lua, val_, static_cast<lua_Integer>(start + i + 1));
+    }
+  });
+}
+
 void Local<Array>::clear() const {
   auto len = size();
   for (size_t i = 0; i < len; ++i) {
@@ -437,4 +457,8 @@ void Local<ByteBuffer>::commit() const {}
 
 void Local<ByteBuffer>::sync() const {}
 
+void Local<ByteBuffer>::commit(size_t, size_t) const {}
+
+void Local<ByteBuffer>::sync(size_t, size_t) const {}
+
 }  // namespace script
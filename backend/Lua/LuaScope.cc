@@ -21,30 +21,30 @@
 
 namespace script::lua_backend {
 
-StackFrameScopeImpl::StackFrameScopeImpl(LuaEngine &engine) : engine_(&engine) {
-  pushValue(engine_->lua_, {});
-  base_ = lua_gettop(engine_->lua_);
-}
+// nothing is pushed until returnValue, so a StackFrameScope around a loop body only costs
+// lua_gettop and lua_settop per iteration.
+StackFrameScopeImpl::StackFrameScopeImpl(LuaEngine &engine)
+    : engine_(&engine), base_(lua_gettop(engine.lua_)) {}
 
 int StackFrameScopeImpl::returnRawValue(int val) {
   auto lua = engine_->lua_;
-  auto returnIndex = base_;
+  // the return value takes the first slot of this frame, the rest is dropped on destruction
+  auto returnIndex = base_ + 1;
+  luaEnsureStack(lua, 1);
   if (val == 0) {
     lua_pushnil(lua);
   } else {
     lua_pushvalue(lua, val);
   }
-  lua_replace(lua, returnIndex);
+  if (lua_gettop(lua) > returnIndex) {
+    lua_replace(lua, returnIndex);
+  }
   hasReturnValue_ = true;
   return returnIndex;
 }
 
 StackFrameScopeImpl::~StackFrameScopeImpl() {
-  if (hasReturnValue_) {
-    lua_settop(engine_->lua_, base_);
-  } else {
-    lua_settop(engine_->lua_, base_ - 1);
-  }
+  lua_settop(engine_->lua_, hasReturnValue_ ? base_ + 1 : base_);
 }
 
 EngineScopeImpl::EngineScopeImpl(LuaEngine &engine, LuaEngine *prevEngine)
@@ -153,9 +153,7 @@ Local<Array> Array::newArray(size_t size) {
 
 Local<Array> Array::newArrayImpl(size_t size, const Local<Value>* args) {
   auto ret = newArray(size);
-  for (size_t i = 0; i < size; ++i) {
-    ret.add(args[i]);
-  }
+  ret.setRange(0, size, args);
   return ret;
 }
 
@@ -19,6 +19,7 @@
 
 #include <mutex>
 #include "../../src/types.h"
+#include "../../src/utils/ThreadAffinity.h"
 
 namespace script {
 
@@ -47,7 +48,7 @@ class StackFrameScopeImpl {
 
 class EngineScopeImpl {
   LuaEngine *prevEngine_ = nullptr;
-  std::lock_guard<std::mutex> lockGuard_;
+  std::lock_guard<utils::AffinityMutex<std::mutex>> lockGuard_;
   StackFrameScopeImpl stack_;
 
  public:
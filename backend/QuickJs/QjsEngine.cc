@@ -17,6 +17,7 @@
 
 #include "QjsEngine.h"
 #include <ScriptX/ScriptX.h>
+#include <algorithm>
 
 namespace script::qjs_backend {
 
@@ -78,12 +79,15 @@ constexpr auto kGetByteBufferInfo = R"(
 })
 )";
 
-QjsEngine::QjsEngine(std::shared_ptr<utils::MessageQueue> queue, const QjsFactory& factory)
-    : queue_(queue ? std::move(queue) : std::make_shared<utils::MessageQueue>()) {
+QjsEngine::QjsEngine(std::shared_ptr<utils::MessageQueue> queue, const QjsFactory& factory,
+                     ThreadMode threadMode)
+    : queue_(queue ? std::move(queue) : std::make_shared<utils::MessageQueue>()),
+      runtimeLock_(threadMode == ThreadMode::kSingleThread) {
   if (factory) {
     std::tie(runtime_, context_) = factory();
   } else {
-    runtime_ = JS_NewRuntime();
+    usePool_ = true;
+    runtime_ = JS_NewRuntime2(&kMallocFunctions, this);
     if (runtime_) {
       context_ = JS_NewContext(runtime_);
     }
@@ -94,6 +98,85 @@ QjsEngine::QjsEngine(std::shared_ptr<utils::MessageQueue> queue, const QjsFactor
   }
 
   initEngineResource();
+
+  JS_SetInterruptHandler(
+      runtime_,
+      [](JSRuntime*, void* opaque) -> int {
+        return static_cast<QjsEngine*>(opaque)->terminating_.load(std::memory_order_relaxed);
+      },
+      this);
+}
+
+// every block is prefixed by its size, since js_free doesn't tell
+constexpr size_t kBlockHeaderSize = utils::SizeClassPool::kAlignment;
+
+const JSMallocFunctions QjsEngine::kMallocFunctions = {
+    QjsEngine::poolMalloc, QjsEngine::poolFree, QjsEngine::poolRealloc,
+    QjsEngine::poolUsableSize};
+
+bool QjsEngine::reserveHeap(JSMallocState* s, size_t bytes) {
+  if (s->malloc_size + bytes <= s->malloc_limit) return true;
+
+  auto engine = static_cast<QjsEngine*>(s->opaque);
+  auto newLimit = engine->nearHeapLimit(s->malloc_limit, s->malloc_size);
+  if (newLimit != 0) {
+    s->malloc_limit = newLimit;
+  }
+  // otherwise thrown as an InternalError "out of memory"
+  return s->malloc_size + bytes <= s->malloc_limit;
+}
+
+void* QjsEngine::poolMalloc(JSMallocState* s, size_t size) {
+  if (size == 0 || !reserveHeap(s, size + kBlockHeaderSize)) return nullptr;
+
+  auto engine = static_cast<QjsEngine*>(s->opaque);
+  auto block = static_cast<size_t*>(engine->pool_.allocate(size + kBlockHeaderSize));
+  if (!block) return nullptr;
+
+  *block = size;
+  s->malloc_count++;
+  s->malloc_size += size + kBlockHeaderSize;
+  engine->heapUsed_ = s->malloc_size;
+  return reinterpret_cast<char*>(block) + kBlockHeaderSize;
+}
+
+void QjsEngine::poolFree(JSMallocState* s, void* ptr) {
+  if (!ptr) return;
+
+  auto engine = static_cast<QjsEngine*>(s->opaque);
+  auto block = static_cast<char*>(ptr) - kBlockHeaderSize;
+  auto size = *reinterpret_cast<size_t*>(block);
+  engine->pool_.deallocate(block, size + kBlockHeaderSize);
+  s->malloc_count--;
+  s->malloc_size -= size + kBlockHeaderSize;
+  engine->heapUsed_ = s->malloc_size;
+}
+
+void* QjsEngine::poolRealloc(JSMallocState* s, void* ptr, size_t size) {
+  if (!ptr) return poolMalloc(s, size);
+  if (size == 0) {
+    poolFree(s, ptr);
+    return nullptr;
+  }
+
+  auto engine = static_cast<QjsEngine*>(s->opaque);
+  auto block = static_cast<char*>(ptr) - kBlockHeaderSize;
+  auto oldSize = *reinterpret_cast<size_t*>(block);
+  if (size > oldSize && !reserveHeap(s, size - oldSize)) return nullptr;
+
+  auto newBlock = static_cast<size_t*>(
+      engine->pool_.reallocate(block, oldSize + kBlockHeaderSize, size + kBlockHeaderSize));
+  if (!newBlock) return nullptr;
+
+  *newBlock = size;
+  s->malloc_size = s->malloc_size - oldSize + size;
+  engine->heapUsed_ = s->malloc_size;
+  return reinterpret_cast<char*>(newBlock) + kBlockHeaderSize;
+}
+
+size_t QjsEngine::poolUsableSize(const void* ptr) {
+  if (!ptr) return 0;
+  return *reinterpret_cast<const size_t*>(static_cast<const char*>(ptr) - kBlockHeaderSize);
 }
 
 void QjsEngine::initEngineResource() {
@@ -195,22 +278,53 @@ void QjsEngine::triggerTick() {
   bool no = false;
   if (!isDestroying() && JS_IsJobPending(runtime_) &&
       tickScheduled_.compare_exchange_strong(no, true)) {
+    tickScheduledAt_ = std::chrono::steady_clock::now();
     utils::Message tick(
         [](auto& m) {
           auto eng = static_cast<QjsEngine*>(m.ptr0);
-          JSContext* ctx = nullptr;
           EngineScope scope(eng);
-          while (JS_ExecutePendingJob(eng->runtime_, &ctx) > 0) {
-          }
+          eng->drainPendingJobs();
           eng->tickScheduled_ = false;
+          // post the jobs left over by the budget
+          eng->triggerTick();
         },
         nullptr);
     tick.ptr0 = this;
     tick.tag = this;
+    tick.name = "QjsEngine::tick";
     queue_->postMessage(tick);
   }
 }
 
+void QjsEngine::drainPendingJobs() {
+  using std::chrono::steady_clock;
+  auto start = steady_clock::now();
+  microtaskDelay_ = (std::max)(microtaskDelay_, std::chrono::nanoseconds(start - tickScheduledAt_));
+
+  size_t count = 0;
+  {
+    ExecutionScope execution(this);
+    JSContext* ctx = nullptr;
+    while (microtaskJobLimit_ == 0 || count < microtaskJobLimit_) {
+      if (count != 0 && microtaskTimeLimit_.count() != 0 &&
+          steady_clock::now() - start >= microtaskTimeLimit_) {
+        break;
+      }
+      if (JS_ExecutePendingJob(runtime_, &ctx) <= 0) break;
+      ++count;
+    }
+  }
+
+  microtaskCount_ += count;
+  ++microtaskDrainCount_;
+  microtaskTime_ += steady_clock::now() - start;
+}
+
+void QjsEngine::setMicrotaskBudget(size_t maxJobs, std::chrono::nanoseconds maxTime) {
+  microtaskJobLimit_ = maxJobs;
+  microtaskTimeLimit_ = maxTime;
+}
+
 void QjsEngine::extendLifeTimeToNextLoop(JSValue value) {
   // schedule -> JS_Free(ref)
   class ExtendLifeTime {
@@ -256,8 +370,10 @@ Local<Value> QjsEngine::eval(const Local<String>& script, const Local<Value>& so
 
   if (sourceFile.isString()) {
     StringHolder source(sourceFile.asString());
+    ExecutionScope execution(this);
     ret = JS_Eval(context_, sh.c_str(), sh.length(), source.c_str(), JS_EVAL_TYPE_GLOBAL);
   } else {
+    ExecutionScope execution(this);
     ret = JS_Eval(context_, sh.c_str(), sh.length(), "<unknown>", JS_EVAL_TYPE_GLOBAL);
   }
   qjs_backend::checkException(ret);
@@ -267,22 +383,111 @@ Local<Value> QjsEngine::eval(const Local<String>& script, const Local<Value>& so
   return Local<Value>(ret);
 }
 
+std::vector<uint8_t> QjsEngine::compileBytecode(const Local<String>& script,
+                                                const Local<String>& sourceFile) {
+  Tracer trace(this, "QjsEngine::compileBytecode");
+  StringHolder sh(script);
+  StringHolder source(sourceFile);
+
+  auto function = JS_Eval(context_, sh.c_str(), sh.length(), source.c_str(),
+                          JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+  qjs_backend::checkException(function);
+
+  size_t size = 0;
+  auto buffer = JS_WriteObject(context_, &size, function, JS_WRITE_OBJ_BYTECODE);
+  JS_FreeValue(context_, function);
+  if (!buffer) {
+    qjs_backend::checkException(-1, "failed to write bytecode");
+  }
+
+  std::vector<uint8_t> ret(buffer, buffer + size);
+  js_free(context_, buffer);
+  return ret;
+}
+
+Local<Value> QjsEngine::evalBytecode(const void* bytecode, size_t size) {
+  Tracer trace(this, "QjsEngine::evalBytecode");
+  auto function = JS_ReadObject(context_, static_cast<const uint8_t*>(bytecode), size,
+                                JS_READ_OBJ_BYTECODE);
+  qjs_backend::checkException(function);
+
+  JSValue ret = JS_UNDEFINED;
+  {
+    ExecutionScope execution(this);
+    // takes the function
+    ret = JS_EvalFunction(context_, function);
+  }
+  qjs_backend::checkException(ret);
+
+  triggerTick();
+
+  return Local<Value>(ret);
+}
+
+Local<Value> QjsEngine::evalBytecode(const Local<ByteBuffer>& bytecode) {
+  return evalBytecode(bytecode.getRawBytes(), bytecode.byteLength());
+}
+
 std::shared_ptr<utils::MessageQueue> QjsEngine::messageQueue() { return queue_; }
 
 void QjsEngine::gc() {
   EngineScope scope(this);
   if (isDestroying() || pauseGcCount_ != 0) return;
+  recordGcBegin();
+  auto start = std::chrono::steady_clock::now();
   JS_RunGC(runtime_);
+  recordGcEnd(std::chrono::steady_clock::now() - start);
 }
 
 size_t QjsEngine::getHeapSize() {
   EngineScope scope(this);
+  if (usePool_) return heapUsed_;
   JSMemoryUsage usage{};
   JS_ComputeMemoryUsage(runtime_, &usage);
   return usage.memory_used_size;
 }
 
-void QjsEngine::adjustAssociatedMemory(int64_t count) {}
+void QjsEngine::adjustAssociatedMemory(int64_t count) { recordAssociatedMemory(count); }
+
+bool QjsEngine::terminateExecution() {
+  // polled by the interrupt handler
+  terminating_.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void QjsEngine::cancelTerminateExecution() {
+  terminating_.store(false, std::memory_order_relaxed);
+}
+
+bool QjsEngine::setHeapLimit(size_t bytes) {
+  EngineScope scope(this);
+  // allocation beyond the limit fails, and is thrown as an InternalError "out of memory"
+  JS_SetMemoryLimit(runtime_, bytes == 0 ? static_cast<size_t>(-1) : bytes);
+  return true;
+}
+
+EngineStats QjsEngine::getStats() {
+  EngineScope scope(this);
+  auto stats = ScriptEngine::getStats();
+
+  if (usePool_) {
+    // JS_ComputeMemoryUsage walks the whole heap, the pool keeps the numbers
+    stats.totalHeapSize = (std::max)(stats.usedHeapSize, pool_.reservedBytes());
+  } else {
+    JSMemoryUsage usage{};
+    JS_ComputeMemoryUsage(runtime_, &usage);
+    stats.usedHeapSize = usage.memory_used_size;
+    stats.totalHeapSize = usage.malloc_size;
+  }
+
+  stats.globalCount = globalWeakBookkeeping_.globalCount();
+  stats.weakCount = globalWeakBookkeeping_.weakCount();
+  stats.microtaskCount = microtaskCount_;
+  stats.microtaskDrainCount = microtaskDrainCount_;
+  stats.microtaskTime = microtaskTime_;
+  stats.microtaskDelay = microtaskDelay_;
+  return stats;
+}
 
 ScriptLanguage QjsEngine::getLanguageType() { return ScriptLanguage::kJavaScript; }
 
@@ -18,14 +18,21 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "../../src/Engine.h"
 #include "../../src/Exception.h"
 #include "../../src/utils/GlobalWeakBookkeeping.hpp"
 #include "../../src/utils/MessageQueue.h"
+#include "../../src/utils/SizeClassPool.h"
+#include "../../src/utils/ThreadAffinity.h"
 #include "QjsHelper.h"
 
 namespace script::qjs_backend {
@@ -33,6 +40,37 @@ namespace script::qjs_backend {
 using RawFunctionCallback = Local<Value> (*)(const Arguments& args, void* data1, void* data2,
                                              bool isConstructorCall);
 
+/**
+ * resolve a normalized module name into its source, return false if not found.
+ * relative imports are normalized against the importing module, ie. "./b.js" imported from
+ * "lib/a.js" is "lib/b.js".
+ */
+using QjsModuleLoader = std::function<bool(const std::string& moduleName, std::string& source)>;
+
+/**
+ * bytecode of the modules compiled by QjsEngine, by module name.
+ * Can be shared by engines (of the same QuickJs version) on any thread, so that each module is
+ * parsed once per process instead of once per runtime.
+ */
+class QjsModuleCache {
+ public:
+  QjsModuleCache() = default;
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(QjsModuleCache);
+
+  std::shared_ptr<const std::vector<uint8_t>> find(const std::string& moduleName) const;
+
+  void put(const std::string& moduleName, std::vector<uint8_t> bytecode);
+
+  size_t size() const;
+
+  void clear();
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<const std::vector<uint8_t>>> modules_;
+};
+
 class QjsEngine : public ScriptEngine {
  private:
   static JSClassID kPointerClassId;
@@ -47,12 +85,30 @@ class QjsEngine : public ScriptEngine {
   JSRuntime* runtime_ = nullptr;
   JSContext* context_ = nullptr;
 
-  std::recursive_mutex runtimeLock_{};
+  // no-op in ThreadMode::kSingleThread
+  utils::AffinityMutex<std::recursive_mutex> runtimeLock_;
+
+  // allocator of the runtime created by QjsEngine itself, see kMallocFunctions
+  utils::SizeClassPool pool_;
+  bool usePool_ = false;
+  // mirror of JSMallocState::malloc_size, which is not accessible from outside
+  size_t heapUsed_ = 0;
 
   // state
   int pauseGcCount_ = 0;
   bool isDestroying_ = false;
   std::atomic_bool tickScheduled_ = false;
+  // see setMicrotaskBudget, 0 for no limit
+  size_t microtaskJobLimit_ = 0;
+  std::chrono::nanoseconds microtaskTimeLimit_{0};
+  std::chrono::steady_clock::time_point tickScheduledAt_{};
+  uint64_t microtaskCount_ = 0;
+  uint64_t microtaskDrainCount_ = 0;
+  std::chrono::nanoseconds microtaskTime_{0};
+  std::chrono::nanoseconds microtaskDelay_{0};
+  // see terminateExecution
+  std::atomic_bool terminating_ = false;
+  int executionDepth_ = 0;
 
   /**
    * key: ClassDefine
@@ -69,12 +125,19 @@ class QjsEngine : public ScriptEngine {
   JSValue helperFunctionGetByteBufferInfo_ = {};
   JSAtom helperSymbolInternalStore_ = JS_ATOM_NULL;
 
+  // see setModuleLoader and registerNativeModule
+  QjsModuleLoader moduleLoader_;
+  std::shared_ptr<QjsModuleCache> moduleCache_;
+  std::unordered_map<std::string, const internal::ClassDefineState*> nativeModules_;
+  std::unordered_map<JSModuleDef*, const internal::ClassDefineState*> nativeModuleDefs_;
+
  public:
   using QjsFactory = std::function<std::pair<JSRuntime*, JSContext*>()>;
 
  public:
   explicit QjsEngine(std::shared_ptr<::script::utils::MessageQueue> queue = nullptr,
-                     const QjsFactory& factory = nullptr);
+                     const QjsFactory& factory = nullptr,
+                     ThreadMode threadMode = ThreadMode::kMultiThread);
 
   SCRIPTX_DISALLOW_COPY_AND_MOVE(QjsEngine);
 
@@ -94,6 +157,59 @@ class QjsEngine : public ScriptEngine {
   Local<Value> eval(const Local<String>& script) override;
   using ScriptEngine::eval;
 
+  /**
+   * compile the script into QuickJs bytecode without running it, see evalBytecode.
+   * the scriptx-qjsc tool does the same at build time.
+   */
+  std::vector<uint8_t> compileBytecode(const Local<String>& script,
+                                       const Local<String>& sourceFile);
+
+  /**
+   * run bytecode from compileBytecode or scriptx-qjsc, skipping the parser.
+   * The bytecode must come from the same QuickJs version, and is not verified on load,
+   * only run trusted input.
+   */
+  Local<Value> evalBytecode(const void* bytecode, size_t size);
+  Local<Value> evalBytecode(const Local<ByteBuffer>& bytecode);
+
+  /**
+   * set the loader of ES modules imported by evalModule or import(), each module is loaded once
+   * per engine and shared by all importers.
+   * @param cache optional, compiled modules are looked up here before calling the loader,
+   * and added to it after compiling.
+   */
+  void setModuleLoader(QjsModuleLoader loader, std::shared_ptr<QjsModuleCache> cache = nullptr);
+
+  /**
+   * make a static only ClassDefine importable as an ES module, ie.
+   * import { add } from "native:math", or import math from "native:math".
+   * The static functions and properties are named exports, the default export is an object like
+   * the one registerNativeClass sets.
+   * note: a named property export is evaluated once when the module is linked, the getter is
+   * not called again and the setter is not exported, use the default export for live properties.
+   * @param define must be valid until the engine is destroyed.
+   */
+  void registerNativeModule(const std::string& moduleName, const ClassDefine<void>& define);
+
+  /**
+   * evaluate the script as an ES module named moduleName.
+   * With QuickJs versions that support top level await (2024-01-13), the pending jobs are run
+   * under the microtask budget (see setMicrotaskBudget) to settle the evaluation promise.
+   * @return undefined, or the evaluation promise with top level await, which is still pending
+   * if the module awaits something not settled yet, or the budget is used up.
+   * @throw Exception if the module throws at top level, or the evaluation promise is rejected
+   * by the pending jobs run here.
+   */
+  Local<Value> evalModule(const Local<String>& script, const Local<String>& moduleName);
+
+  /**
+   * limit the pending jobs (promise reactions) run by one message of the MessageQueue, the rest
+   * is left to a new message, so a long promise chain doesn't starve the other messages.
+   * At least one job is run per message. 0 for no limit, which is the default.
+   * see EngineStats::microtaskCount and friends.
+   */
+  void setMicrotaskBudget(size_t maxJobs, std::chrono::nanoseconds maxTime = {});
+
   std::shared_ptr<utils::MessageQueue> messageQueue() override;
 
   void gc() override;
@@ -102,6 +218,14 @@ class QjsEngine : public ScriptEngine {
 
   void adjustAssociatedMemory(int64_t count) override;
 
+  EngineStats getStats() override;
+
+  bool setHeapLimit(size_t bytes) override;
+
+  bool terminateExecution() override;
+
+  void cancelTerminateExecution() override;
+
   ScriptLanguage getLanguageType() override;
 
   std::string getEngineVersion() override;
@@ -124,6 +248,18 @@ class QjsEngine : public ScriptEngine {
                                       const Local<script::Value>* args) override;
 
  private:
+  static const JSMallocFunctions kMallocFunctions;
+
+  static void* poolMalloc(JSMallocState* s, size_t size);
+
+  static void poolFree(JSMallocState* s, void* ptr);
+
+  static void* poolRealloc(JSMallocState* s, void* ptr, size_t size);
+
+  static size_t poolUsableSize(const void* ptr);
+
+  static bool reserveHeap(JSMallocState* s, size_t bytes);
+
   struct BookKeepFetcher;
   friend struct QjsBookKeepFetcher;
 
@@ -137,11 +273,24 @@ class QjsEngine : public ScriptEngine {
 
   void initEngineResource();
 
+  void installModuleLoader();
+
+  static JSModuleDef* moduleLoader(JSContext* context, const char* moduleName, void* opaque);
+
+  static int initNativeModule(JSContext* context, JSModuleDef* module);
+
+  JSModuleDef* loadModule(const std::string& moduleName);
+
+  JSModuleDef* newNativeModule(const std::string& moduleName,
+                               const internal::ClassDefineState* define);
+
   /**
    * similar to js_std_loop
    */
   void triggerTick();
 
+  void drainPendingJobs();
+
   void extendLifeTimeToNextLoop(JSValue value);
 
   template <typename T, typename... Args>
@@ -179,6 +328,8 @@ class QjsEngine : public ScriptEngine {
 
   friend class PauseGc;
 
+  friend class ExecutionScope;
+
   friend class EngineScopeImpl;
   friend class ExitEngineScopeImpl;
   friend struct GlobalRefState;
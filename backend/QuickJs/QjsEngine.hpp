@@ -38,4 +38,20 @@ class PauseGc {
   ~PauseGc() { engine_->pauseGcCount_--; }
 };
 
+/**
+ * wraps a call into js, a terminated execution is over when the outermost one returns.
+ */
+class ExecutionScope {
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(ExecutionScope);
+  QjsEngine* engine_;
+
+ public:
+  explicit ExecutionScope(QjsEngine* engine) : engine_(engine) { engine_->executionDepth_++; }
+  ~ExecutionScope() {
+    if (--engine_->executionDepth_ == 0) {
+      engine_->terminating_.store(false, std::memory_order_relaxed);
+    }
+  }
+};
+
 }  // namespace script::qjs_backend
\ No newline at end of file
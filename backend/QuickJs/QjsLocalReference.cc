@@ -326,6 +326,7 @@ Local<Value> Local<Function>::callImpl(const Local<Value>& thiz, size_t size,
           array[i] = qjs_interop::peekLocal(args[i]);
         }
 
+        ExecutionScope execution(&engine);
         ret = JS_Call(context, val_,
                       thiz.isObject() ? thiz.val_ : qjs_interop::peekLocal(engine.getGlobal()),
                       static_cast<int>(size), array);
@@ -369,6 +370,23 @@ void Local<Array>::set(size_t index, const script::Local<script::Value>& value)
 
 void Local<Array>::add(const script::Local<script::Value>& value) const { set(size(), value); }
 
+void Local<Array>::getRange(size_t start, size_t count, Local<Value>* out) const {
+  auto context = qjs_backend::currentContext();
+  for (size_t i = 0; i < count; ++i) {
+    auto ret = JS_GetPropertyUint32(context, val_, static_cast<uint32_t>(start + i));
+    qjs_backend::checkException(ret);
+    out[i] = qjs_interop::makeLocal<Value>(ret);
+  }
+}
+
+void Local<Array>::setRange(size_t start, size_t count, const Local<Value>* values) const {
+  auto context = qjs_backend::currentContext();
+  for (size_t i = 0; i < count; ++i) {
+    qjs_backend::checkException(JS_SetPropertyInt64(
+        context, val_, static_cast<int64_t>(start + i), qjs_interop::getLocal(values[i])));
+  }
+}
+
 void Local<Array>::clear() const {
   auto& engine = qjs_backend::currentEngine();
 
@@ -467,6 +485,10 @@ void Local<ByteBuffer>::commit() const {}
 
 void Local<ByteBuffer>::sync() const {}
 
+void Local<ByteBuffer>::commit(size_t, size_t) const {}
+
+void Local<ByteBuffer>::sync(size_t, size_t) const {}
+
 size_t Local<ByteBuffer>::byteLength() const {
   val_.fillTypeAndSize();
   return val_.size_;
@@ -0,0 +1,216 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QjsEngine.h"
+#include <ScriptX/ScriptX.h>
+
+namespace script::qjs_backend {
+
+std::shared_ptr<const std::vector<uint8_t>> QjsModuleCache::find(
+    const std::string& moduleName) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = modules_.find(moduleName);
+  return it == modules_.end() ? nullptr : it->second;
+}
+
+void QjsModuleCache::put(const std::string& moduleName, std::vector<uint8_t> bytecode) {
+  auto shared = std::make_shared<const std::vector<uint8_t>>(std::move(bytecode));
+  std::lock_guard<std::mutex> lock(mutex_);
+  modules_[moduleName] = std::move(shared);
+}
+
+size_t QjsModuleCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return modules_.size();
+}
+
+void QjsModuleCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  modules_.clear();
+}
+
+void QjsEngine::setModuleLoader(QjsModuleLoader loader, std::shared_ptr<QjsModuleCache> cache) {
+  moduleLoader_ = std::move(loader);
+  moduleCache_ = std::move(cache);
+  installModuleLoader();
+}
+
+void QjsEngine::registerNativeModule(const std::string& moduleName,
+                                     const ClassDefine<void>& define) {
+  auto state = static_cast<const internal::ClassDefineState*>(&define);
+  if (state->instanceDefine.constructor) {
+    throw Exception("native module must be static only: " + moduleName);
+  }
+  nativeModules_[moduleName] = state;
+  installModuleLoader();
+}
+
+void QjsEngine::installModuleLoader() {
+  // the default normalizer resolves relative names against the importing module
+  JS_SetModuleLoaderFunc(runtime_, nullptr, &QjsEngine::moduleLoader, this);
+}
+
+Local<Value> QjsEngine::evalModule(const Local<String>& script, const Local<String>& moduleName) {
+  Tracer trace(this, "QjsEngine::evalModule");
+  StringHolder sh(script);
+  StringHolder name(moduleName);
+
+  JSValue ret = JS_UNDEFINED;
+  {
+    ExecutionScope execution(this);
+    ret = JS_Eval(context_, sh.c_str(), sh.length(), name.c_str(), JS_EVAL_TYPE_MODULE);
+  }
+  qjs_backend::checkException(ret);
+  auto result = Local<Value>(ret);
+
+  if (Promise::isPromise(result)) {
+    // with top level await, QuickJs returns the evaluation promise, and a module throwing at
+    // top level rejects it instead.
+    struct Evaluation {
+      bool active = true;
+      bool rejected = false;
+      Global<Value> reason;
+    };
+    auto evaluation = std::make_shared<Evaluation>();
+    auto onRejected = Function::newFunction([evaluation](const Local<Value>& reason) {
+      if (!evaluation->active) return;
+      evaluation->rejected = true;
+      evaluation->reason = reason;
+    });
+    auto promise = result.asObject();
+    promise.get("then").asFunction().call(promise, Local<Value>(), onRejected);
+
+    // under the microtask budget, a rejection after this drain is left to the returned promise
+    drainPendingJobs();
+
+    evaluation->active = false;
+    if (evaluation->rejected) {
+      Exception exception(evaluation->reason.get());
+      evaluation->reason.reset();
+      throw exception;
+    }
+  }
+
+  triggerTick();
+
+  return result;
+}
+
+JSModuleDef* QjsEngine::moduleLoader(JSContext*, const char* moduleName, void* opaque) {
+  // only called once per module name, QuickJs keeps the loaded modules in the context
+  auto engine = static_cast<QjsEngine*>(opaque);
+  try {
+    return engine->loadModule(moduleName);
+  } catch (const Exception& e) {
+    qjs_backend::throwException(e, engine);
+    return nullptr;
+  }
+}
+
+JSModuleDef* QjsEngine::loadModule(const std::string& moduleName) {
+  Tracer trace(this, "QjsEngine::loadModule");
+
+  auto native = nativeModules_.find(moduleName);
+  if (native != nativeModules_.end()) {
+    return newNativeModule(moduleName, native->second);
+  }
+
+  JSValue module = JS_UNDEFINED;
+  auto cached = moduleCache_ ? moduleCache_->find(moduleName) : nullptr;
+  if (cached) {
+    module = JS_ReadObject(context_, cached->data(), cached->size(), JS_READ_OBJ_BYTECODE);
+    qjs_backend::checkException(module);
+  } else {
+    std::string source;
+    if (!moduleLoader_ || !moduleLoader_(moduleName, source)) {
+      throw Exception("module not found: " + moduleName);
+    }
+    module = JS_Eval(context_, source.c_str(), source.length(), moduleName.c_str(),
+                     JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    qjs_backend::checkException(module);
+
+    if (moduleCache_) {
+      size_t size = 0;
+      auto buffer = JS_WriteObject(context_, &size, module, JS_WRITE_OBJ_BYTECODE);
+      if (buffer) {
+        moduleCache_->put(moduleName, std::vector<uint8_t>(buffer, buffer + size));
+        js_free(context_, buffer);
+      } else {
+        // not cached, but the module is still usable
+        JS_FreeValue(context_, JS_GetException(context_));
+      }
+    }
+  }
+
+  // the module is owned by the context
+  auto def = static_cast<JSModuleDef*>(JS_VALUE_GET_PTR(module));
+  JS_FreeValue(context_, module);
+  return def;
+}
+
+JSModuleDef* QjsEngine::newNativeModule(const std::string& moduleName,
+                                        const internal::ClassDefineState* define) {
+  auto module = JS_NewCModule(context_, moduleName.c_str(), &QjsEngine::initNativeModule);
+  if (!module) {
+    qjs_backend::checkException(-1, "failed to create native module");
+  }
+
+  for (auto&& f : define->staticDefine.functions) {
+    qjs_backend::checkException(JS_AddModuleExport(context_, module, f.name.c_str()));
+  }
+  for (auto&& prop : define->staticDefine.properties) {
+    qjs_backend::checkException(JS_AddModuleExport(context_, module, prop.name.c_str()));
+  }
+  qjs_backend::checkException(JS_AddModuleExport(context_, module, "default"));
+
+  nativeModuleDefs_.emplace(module, define);
+  return module;
+}
+
+int QjsEngine::initNativeModule(JSContext* context, JSModuleDef* module) {
+  auto engine = &qjs_backend::currentEngine();
+  auto define = engine->nativeModuleDefs_.at(module);
+
+  try {
+    StackFrameScope stack;
+    auto object = Object::newObject();
+    engine->registerNativeStatic(object, define->staticDefine);
+    auto exports = qjs_interop::peekLocal(object);
+
+    auto exportProperty = [&](const std::string& name) {
+      auto value = JS_GetPropertyStr(context, exports, name.c_str());
+      qjs_backend::checkException(value);
+      // takes the value
+      qjs_backend::checkException(JS_SetModuleExport(context, module, name.c_str(), value));
+    };
+    for (auto&& f : define->staticDefine.functions) {
+      exportProperty(f.name);
+    }
+    // module exports are plain bindings, so a property is exported as its current value
+    for (auto&& prop : define->staticDefine.properties) {
+      exportProperty(prop.name);
+    }
+    qjs_backend::checkException(
+        JS_SetModuleExport(context, module, "default", qjs_interop::getLocal(object)));
+    return 0;
+  } catch (const Exception& e) {
+    qjs_backend::throwException(e, engine);
+    return -1;
+  }
+}
+
+}  // namespace script::qjs_backend
@@ -0,0 +1,94 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// scriptx-qjsc: precompile JavaScript into QuickJs bytecode at build time,
+// the output is loaded by QjsEngine::evalBytecode.
+//
+// usage: scriptx-qjsc [-n source_name] -o <output> <input.js>
+
+#include <ScriptX/ScriptX.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+int usage() {
+  std::cerr << "usage: scriptx-qjsc [-n source_name] -o <output> <input.js>" << std::endl;
+  return 2;
+}
+
+bool readFile(const std::string& path, std::string& content) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string input;
+  std::string output;
+  std::string sourceName;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      sourceName = argv[++i];
+    } else if (argv[i][0] != '-' && input.empty()) {
+      input = argv[i];
+    } else {
+      return usage();
+    }
+  }
+  if (input.empty() || output.empty()) return usage();
+  // the file name shown in stack traces
+  if (sourceName.empty()) sourceName = input;
+
+  std::string source;
+  if (!readFile(input, source)) {
+    std::cerr << "scriptx-qjsc: can't read " << input << std::endl;
+    return 1;
+  }
+
+  auto qjs = new script::qjs_backend::QjsEngine();
+  script::UniqueEnginePtr engine(qjs);
+  script::EngineScope scope(qjs);
+
+  std::vector<uint8_t> bytecode;
+  try {
+    bytecode = qjs->compileBytecode(script::String::newString(source),
+                                    script::String::newString(sourceName));
+  } catch (const script::Exception& e) {
+    std::cerr << input << ": " << e.message() << std::endl;
+    return 1;
+  }
+
+  std::ofstream out(output, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(bytecode.data()),
+            static_cast<std::streamsize>(bytecode.size()));
+  if (!out) {
+    std::cerr << "scriptx-qjsc: can't write " << output << std::endl;
+    return 1;
+  }
+  return 0;
+}
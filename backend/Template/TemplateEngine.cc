@@ -50,7 +50,7 @@ std::shared_ptr<utils::MessageQueue> TemplateEngine::messageQueue() {
 
 void TemplateEngine::gc() {}
 
-void TemplateEngine::adjustAssociatedMemory(int64_t count) {}
+void TemplateEngine::adjustAssociatedMemory(int64_t count) { recordAssociatedMemory(count); }
 
 ScriptLanguage TemplateEngine::getLanguageType() { return ScriptLanguage::kJavaScript; }
 
@@ -197,6 +197,10 @@ void Local<Array>::set(size_t index, const script::Local<script::Value>& value)
 
 void Local<Array>::add(const script::Local<script::Value>& value) const { set(size(), value); }
 
+void Local<Array>::getRange(size_t start, size_t count, Local<Value>* out) const {}
+
+void Local<Array>::setRange(size_t start, size_t count, const Local<Value>* values) const {}
+
 void Local<Array>::clear() const {}
 
 ByteBuffer::Type Local<ByteBuffer>::getType() const { return ByteBuffer::Type::kFloat32; }
@@ -207,6 +211,10 @@ void Local<ByteBuffer>::commit() const {}
 
 void Local<ByteBuffer>::sync() const {}
 
+void Local<ByteBuffer>::commit(size_t, size_t) const {}
+
+void Local<ByteBuffer>::sync(size_t, size_t) const {}
+
 size_t Local<ByteBuffer>::byteLength() const { return 0; }
 
 void* Local<ByteBuffer>::getRawBytes() const { return nullptr; }
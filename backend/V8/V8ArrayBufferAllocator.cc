@@ -0,0 +1,122 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "V8ArrayBufferAllocator.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define SCRIPTX_V8_MMAP_ARRAY_BUFFER
+#endif
+
+namespace script::v8_backend {
+
+V8ArrayBufferAllocator::~V8ArrayBufferAllocator() {
+  for (auto& bucket : buckets_) {
+    while (bucket.freeList) {
+      auto next = bucket.freeList->next;
+      std::free(bucket.freeList);
+      bucket.freeList = next;
+    }
+  }
+}
+
+size_t V8ArrayBufferAllocator::bucketOf(size_t length) {
+  size_t bucket = 0;
+  while ((size_t(1) << (bucket + kMinPooledSizeBits)) < length) {
+    ++bucket;
+  }
+  return bucket;
+}
+
+void* V8ArrayBufferAllocator::allocate(size_t length, bool zeroFill) {
+  void* ret = nullptr;
+
+  if (length <= kMaxPooledSize) {
+    auto bucketIndex = bucketOf(length);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& bucket = buckets_[bucketIndex];
+      if (bucket.freeList) {
+        ret = bucket.freeList;
+        bucket.freeList = bucket.freeList->next;
+        bucket.cachedBytes -= size_t(1) << (bucketIndex + kMinPooledSizeBits);
+      }
+    }
+    if (ret) {
+      if (zeroFill) std::memset(ret, 0, length);
+    } else {
+      auto size = size_t(1) << (bucketIndex + kMinPooledSizeBits);
+      ret = zeroFill ? std::calloc(1, size) : std::malloc(size);
+    }
+  }
+#ifdef SCRIPTX_V8_MMAP_ARRAY_BUFFER
+  else if (length >= kMappedSize) {
+    ret = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ret == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+    madvise(ret, length, MADV_HUGEPAGE);
+#endif
+  }
+#endif
+  else {
+    ret = zeroFill ? std::calloc(1, length) : std::malloc(length);
+  }
+
+  if (ret) allocatedBytes_.fetch_add(length, std::memory_order_relaxed);
+  return ret;
+}
+
+void* V8ArrayBufferAllocator::Allocate(size_t length) { return allocate(length, true); }
+
+void* V8ArrayBufferAllocator::AllocateUninitialized(size_t length) {
+  return allocate(length, false);
+}
+
+void V8ArrayBufferAllocator::Free(void* data, size_t length) {
+  if (!data) return;
+  allocatedBytes_.fetch_sub(length, std::memory_order_relaxed);
+
+  if (length <= kMaxPooledSize) {
+    auto bucketIndex = bucketOf(length);
+    auto size = size_t(1) << (bucketIndex + kMinPooledSizeBits);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& bucket = buckets_[bucketIndex];
+      if (bucket.cachedBytes + size <= kMaxCachedBytes) {
+        auto block = static_cast<FreeBlock*>(data);
+        block->next = bucket.freeList;
+        bucket.freeList = block;
+        bucket.cachedBytes += size;
+        return;
+      }
+    }
+    std::free(data);
+    return;
+  }
+
+#ifdef SCRIPTX_V8_MMAP_ARRAY_BUFFER
+  if (length >= kMappedSize) {
+    munmap(data, length);
+    return;
+  }
+#endif
+  std::free(data);
+}
+
+}  // namespace script::v8_backend
@@ -0,0 +1,87 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include "../../src/foundation.h"
+
+SCRIPTX_BEGIN_INCLUDE_LIBRARY
+#include <v8.h>
+SCRIPTX_END_INCLUDE_LIBRARY
+
+namespace script::v8_backend {
+
+/**
+ * The ArrayBuffer allocator of an isolate created by V8Engine.
+ *
+ * 1. buffers up to kMaxPooledSize are rounded up to a power of 2, and kept in a per-size cache
+ * when freed (up to kMaxCachedBytes per size), short-lived buffers skip malloc and free.
+ * 2. buffers of kMappedSize or more are mapped directly from the system (transparent huge pages
+ * on linux), which are zero filled already.
+ * 3. the rest goes to calloc/malloc like the default allocator.
+ *
+ * V8 may free buffers on its background threads, so the cache is guarded by a mutex.
+ */
+class V8ArrayBufferAllocator : public v8::ArrayBuffer::Allocator {
+ public:
+  static constexpr size_t kMinPooledSizeBits = 4;
+  static constexpr size_t kMaxPooledSizeBits = 16;
+  static constexpr size_t kMaxPooledSize = size_t(1) << kMaxPooledSizeBits;
+  static constexpr size_t kBucketCount = kMaxPooledSizeBits - kMinPooledSizeBits + 1;
+  static constexpr size_t kMaxCachedBytes = 256 * 1024;
+  static constexpr size_t kMappedSize = 2 * 1024 * 1024;
+
+  V8ArrayBufferAllocator() = default;
+
+  ~V8ArrayBufferAllocator() override;
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(V8ArrayBufferAllocator);
+
+  void* Allocate(size_t length) override;
+
+  void* AllocateUninitialized(size_t length) override;
+
+  void Free(void* data, size_t length) override;
+
+  /**
+   * @return bytes of live buffers, thread safe.
+   */
+  size_t allocatedBytes() const { return allocatedBytes_.load(std::memory_order_relaxed); }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct Bucket {
+    FreeBlock* freeList = nullptr;
+    size_t cachedBytes = 0;
+  };
+
+  static size_t bucketOf(size_t length);
+
+  void* allocate(size_t length, bool zeroFill);
+
+  std::mutex mutex_;
+  Bucket buckets_[kBucketCount];
+  std::atomic<size_t> allocatedBytes_{0};
+};
+
+}  // namespace script::v8_backend
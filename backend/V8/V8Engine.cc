@@ -25,18 +25,20 @@
 namespace script::v8_backend {
 
 // create a master engine (opposite to slave engine)
-V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> mq) : V8Engine(std::move(mq), nullptr) {}
+V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> mq, ThreadMode threadMode)
+    : V8Engine(std::move(mq), nullptr, threadMode) {}
 
 V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> mq,
-                   const std::function<v8::Isolate*()>& isolateFactory)
-    : v8Platform_(V8Platform::getPlatform()),
+                   const std::function<v8::Isolate*()>& isolateFactory, ThreadMode threadMode)
+    : affinity_(threadMode == ThreadMode::kSingleThread),
+      v8Platform_(V8Platform::getPlatform()),
       messageQueue_(mq ? std::move(mq) : std::make_shared<utils::MessageQueue>()) {
   // create isolation
   if (isolateFactory) {
     isolate_ = isolateFactory();
   } else {
     v8::Isolate::CreateParams createParams;
-    allocator_.reset(v8::ArrayBuffer::Allocator::NewDefaultAllocator());
+    allocator_ = std::make_unique<V8ArrayBufferAllocator>();
     createParams.array_buffer_allocator = allocator_.get();
     isolate_ = v8::Isolate::New(createParams);
   }
@@ -67,7 +69,7 @@ V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue, v8::Isolat
 }
 
 void V8Engine::initContext() {
-  v8::Locker locker(isolate_);
+  V8Locker locker(*this);
   v8::Isolate::Scope is(isolate_);
   v8::HandleScope handle_scope(isolate_);
   if (context_.IsEmpty()) {
@@ -76,8 +78,77 @@ void V8Engine::initContext() {
   }
   internalStoreSymbol_ = v8::Global<v8::Symbol>(isolate_, v8::Symbol::New(isolate_));
   constructorMarkSymbol_ = v8::Global<v8::Symbol>(isolate_, v8::Symbol::New(isolate_));
+
+  isolate_->AddGCPrologueCallback(onGcPrologue, this);
+  isolate_->AddGCEpilogueCallback(onGcEpilogue, this);
+  if (isOwnIsolate_) {
+    // callbacks are matched by function only, register once per isolate
+    isolate_->AddNearHeapLimitCallback(onNearHeapLimit, this);
+  }
+}
+
+void V8Engine::onGcPrologue(v8::Isolate*, v8::GCType, v8::GCCallbackFlags, void* data) {
+  auto engine = static_cast<V8Engine*>(data);
+  engine->recordGcBegin();
+  engine->gcStartTime_ = std::chrono::steady_clock::now();
+}
+
+void V8Engine::onGcEpilogue(v8::Isolate*, v8::GCType, v8::GCCallbackFlags, void* data) {
+  auto engine = static_cast<V8Engine*>(data);
+  engine->recordGcEnd(std::chrono::steady_clock::now() - engine->gcStartTime_);
+
+  if (engine->restoreHeapLimit_) {
+    engine->restoreHeapLimit_ = false;
+    engine->applyHeapLimit();
+  }
+}
+
+size_t V8Engine::onNearHeapLimit(void* data, size_t currentHeapLimit, size_t) {
+  auto engine = static_cast<V8Engine*>(data);
+  v8::HeapStatistics heapStatistics;
+  engine->isolate_->GetHeapStatistics(&heapStatistics);
+
+  auto newLimit = engine->nearHeapLimit(currentHeapLimit, heapStatistics.used_heap_size());
+  if (newLimit > currentHeapLimit) {
+    return newLimit;
+  }
+
+  // V8 aborts the process if the limit is not raised,
+  // terminate the script instead, and give it some room to unwind.
+  engine->isolate_->TerminateExecution();
+  engine->restoreHeapLimit_ = engine->heapLimit_ != 0;
+  return currentHeapLimit + currentHeapLimit / 4;
+}
+
+void V8Engine::applyHeapLimit() {
+  if (heapLimit_ == 0) return;
+  // RemoveNearHeapLimitCallback lowers the heap limit to the given one (but not below the
+  // current heap size), which is the only way to change the limit of an existing isolate.
+  isolate_->RemoveNearHeapLimitCallback(onNearHeapLimit, heapLimit_);
+  isolate_->AddNearHeapLimitCallback(onNearHeapLimit, this);
+}
+
+bool V8Engine::setHeapLimit(size_t bytes) {
+  // the isolate is shared with other engines
+  if (isDestroying() || !isOwnIsolate_) return false;
+  EngineScope engineScope(this);
+  // the limit of an existing isolate can only be lowered, see applyHeapLimit
+  v8::HeapStatistics heapStatistics;
+  isolate_->GetHeapStatistics(&heapStatistics);
+  if (bytes == 0 || bytes > heapStatistics.heap_size_limit()) return false;
+  heapLimit_ = bytes;
+  applyHeapLimit();
+  return true;
 }
 
+bool V8Engine::terminateExecution() {
+  // thread safe
+  isolate_->TerminateExecution();
+  return true;
+}
+
+void V8Engine::cancelTerminateExecution() { isolate_->CancelTerminateExecution(); }
+
 V8Engine::~V8Engine() = default;
 
 // NOLINTNEXTLINE(bugprone-exception-escape)
@@ -104,6 +175,12 @@ void V8Engine::destroy() noexcept {
     nativeRegistry_.clear();
     globalWeakBookkeeping_.clear();
 
+    isolate_->RemoveGCPrologueCallback(onGcPrologue, this);
+    isolate_->RemoveGCEpilogueCallback(onGcEpilogue, this);
+    if (isOwnIsolate_) {
+      isolate_->RemoveNearHeapLimitCallback(onNearHeapLimit, 0);
+    }
+
     internalStoreSymbol_.Reset();
     constructorMarkSymbol_.Reset();
     context_.Reset();
@@ -123,6 +200,7 @@ bool V8Engine::isDestroying() const { return isDestroying_; }
 // create a slave engine from master
 V8Engine::V8Engine(V8Engine* masterEngine)
     : isOwnIsolate_(false),
+      affinity_(masterEngine->affinity_),
       messageQueue_(masterEngine->messageQueue()),
       isolate_(masterEngine->isolate_) {
   initContext();
@@ -274,9 +352,27 @@ size_t V8Engine::getHeapSize() {
 void V8Engine::adjustAssociatedMemory(int64_t count) {
   if (isDestroying()) return;
   EngineScope engineScope(this);
+  recordAssociatedMemory(count);
   isolate_->AdjustAmountOfExternalAllocatedMemory(count);
 }
 
+EngineStats V8Engine::getStats() {
+  EngineScope engineScope(this);
+  auto stats = ScriptEngine::getStats();
+
+  v8::HeapStatistics heapStatistics;
+  isolate_->GetHeapStatistics(&heapStatistics);
+  stats.usedHeapSize = heapStatistics.used_heap_size() + heapStatistics.malloced_memory();
+  stats.totalHeapSize = heapStatistics.total_heap_size() + heapStatistics.malloced_memory();
+  if (allocator_) {
+    stats.externalMemory += static_cast<int64_t>(allocator_->allocatedBytes());
+  }
+
+  stats.globalCount = globalWeakBookkeeping_.globalCount();
+  stats.weakCount = globalWeakBookkeeping_.weakCount();
+  return stats;
+}
+
 void V8Engine::addManagedObject(void* nativeObj, v8::Local<v8::Value> obj,
                                 std::function<void(void*)>&& proc) {
   auto data = std::make_unique<ManagedObject>();
@@ -291,7 +387,7 @@ void V8Engine::addManagedObject(void* nativeObj, v8::Local<v8::Value> obj,
         auto param = static_cast<ManagedObject*>(info.GetParameter());
         auto engine = param->engine;
         {
-          v8::Locker lk(engine->isolate_);
+          V8Locker lk(*engine);
           auto it = engine->managedObject_.find(param);
           assert(it != engine->managedObject_.end());
           engine->managedObject_.erase(it);
@@ -299,7 +395,7 @@ void V8Engine::addManagedObject(void* nativeObj, v8::Local<v8::Value> obj,
           info.SetSecondPassCallback([](const v8::WeakCallbackInfo<void>& data) {
             auto param = static_cast<ManagedObject*>(data.GetParameter());
             auto engine = param->engine;
-            v8::Locker lk(engine->isolate_);
+            V8Locker lk(*engine);
 
             param->cleanupFunc(param->data);
             delete param;
@@ -326,6 +422,8 @@ void V8Engine::removeKeptReference(size_t id) {
 
 constexpr int kInstanceObjectAlignedPointer_ScriptClass = 0;         // ScriptClass* pointer
 constexpr int kInstanceObjectAlignedPointer_PolymorphicPointer = 1;  // the actual type pointer
+constexpr int kInstanceObjectAlignedPointer_ClassDefine = 2;  // the ClassDefineState* as type tag
+constexpr int kInstanceObjectInternalFieldCount = 3;
 
 void V8Engine::performRegisterNativeClass(
     internal::TypeIndex typeIndex, const internal::ClassDefineState* classDefine,
@@ -403,6 +501,9 @@ v8::Local<v8::FunctionTemplate> V8Engine::newConstructor(
           if (!args.IsConstructCall()) {
             throw Exception(u8"constructor can't be called as function");
           }
+          // not an instance until constructed, see performIsInstanceOf
+          args.This()->SetAlignedPointerInInternalField(kInstanceObjectAlignedPointer_ClassDefine,
+                                                        nullptr);
           void* ret;
           if (args.Length() == 2 && args[0]->IsSymbol() &&
               args[0]->StrictEquals(engine->constructorMarkSymbol_.Get(args.GetIsolate())) &&
@@ -424,6 +525,8 @@ v8::Local<v8::FunctionTemplate> V8Engine::newConstructor(
                                                           scriptClass);
             args.This()->SetAlignedPointerInInternalField(
                 kInstanceObjectAlignedPointer_PolymorphicPointer, ret);
+            args.This()->SetAlignedPointerInInternalField(
+                kInstanceObjectAlignedPointer_ClassDefine, classDefine);
             engine->adjustAssociatedMemory(
                 static_cast<int64_t>(classDefine->instanceDefine.instanceSize));
 
@@ -444,7 +547,7 @@ v8::Local<v8::FunctionTemplate> V8Engine::newConstructor(
         }
       },
       data);
-  funcT->InstanceTemplate()->SetInternalFieldCount(2);
+  funcT->InstanceTemplate()->SetInternalFieldCount(kInstanceObjectInternalFieldCount);
   return funcT;
 }
 
@@ -574,6 +677,24 @@ Local<Object> V8Engine::performNewNativeClass(internal::TypeIndex typeIndex,
 
 bool V8Engine::performIsInstanceOf(const Local<script::Value>& value,
                                    const internal::ClassDefineState* classDefine) {
+  if (isOwnIsolate_) {
+    // objects with this many internal fields are created by newConstructor, check the type tag
+    // instead of walking the prototype chain with FunctionTemplate::HasInstance.
+    // the isolate of a node addon has objects of other embedders, use HasInstance there.
+    auto v8Value = toV8(isolate_, value);
+    if (!v8Value->IsObject()) return false;
+    auto obj = v8Value.As<v8::Object>();
+    if (obj->InternalFieldCount() != kInstanceObjectInternalFieldCount ||
+        obj->GetAlignedPointerFromInternalField(kInstanceObjectAlignedPointer_ClassDefine) !=
+            classDefine) {
+      return false;
+    }
+    // the same ClassDefine may be registered to other engines sharing the isolate
+    auto scriptClass = static_cast<ScriptClass*>(
+        obj->GetAlignedPointerFromInternalField(kInstanceObjectAlignedPointer_ScriptClass));
+    return scriptClass->internalState_.scriptEngine_ == this;
+  }
+
   auto it = nativeRegistry_.find(classDefine);
   if (it != nativeRegistry_.end()) {
     auto funcT = it->second.Get(isolate_);
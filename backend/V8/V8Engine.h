@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <unordered_map>
 #include "../../src/Engine.h"
 #include "../../src/Native.h"
@@ -24,6 +25,8 @@
 #include "../../src/Scope.h"
 #include "../../src/Value.h"
 #include "../../src/utils/GlobalWeakBookkeeping.hpp"
+#include "../../src/utils/ThreadAffinity.h"
+#include "V8ArrayBufferAllocator.h"
 #include "V8Helper.h"
 #include "V8Platform.h"
 
@@ -46,11 +49,14 @@ class V8Engine : public ::script::ScriptEngine {
 
  private:
   bool isOwnIsolate_ = true;
+  // bound in ThreadMode::kSingleThread, shared by slave engines
+  const utils::ThreadAffinity affinity_;
   // used only for node addon
   std::unique_ptr<ThreadGlobalScope> threadGlobalScope_ = nullptr;
   std::unordered_map<const void*, v8::Global<v8::FunctionTemplate>> nativeRegistry_;
   std::shared_ptr<V8Platform> v8Platform_;
-  std::unique_ptr<v8::ArrayBuffer::Allocator> allocator_;
+  // null when the isolate is not created by V8Engine
+  std::unique_ptr<V8ArrayBufferAllocator> allocator_;
 
   std::shared_ptr<::script::utils::MessageQueue> messageQueue_;
 
@@ -66,6 +72,12 @@ class V8Engine : public ::script::ScriptEngine {
 
   internal::GlobalWeakBookkeeping globalWeakBookkeeping_;
 
+  std::chrono::steady_clock::time_point gcStartTime_{};
+  // 0 for the limit the isolate was created with
+  size_t heapLimit_ = 0;
+  // the limit is raised to unwind a terminated script, restore it on next gc
+  bool restoreHeapLimit_ = false;
+
   // create a slave engine
   explicit V8Engine(V8Engine* masterEngine);
 
@@ -79,12 +91,14 @@ class V8Engine : public ::script::ScriptEngine {
   v8::Global<v8::Symbol> constructorMarkSymbol_;
 
   explicit V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue,
-                    const std::function<v8::Isolate*()>& isolateFactory);
+                    const std::function<v8::Isolate*()>& isolateFactory,
+                    ThreadMode threadMode = ThreadMode::kMultiThread);
 
   ~V8Engine() override;
 
  public:
-  explicit V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue = {});
+  explicit V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue = {},
+                    ThreadMode threadMode = ThreadMode::kMultiThread);
 
   /**
    * Create a ScriptEngine instance wrapping existing v8 instance, especially for NODE JS addons.
@@ -132,6 +146,14 @@ class V8Engine : public ::script::ScriptEngine {
 
   void adjustAssociatedMemory(int64_t count) override;
 
+  EngineStats getStats() override;
+
+  bool setHeapLimit(size_t bytes) override;
+
+  bool terminateExecution() override;
+
+  void cancelTerminateExecution() override;
+
   ScriptLanguage getLanguageType() override;
 
   std::string getEngineVersion() override;
@@ -154,6 +176,16 @@ class V8Engine : public ::script::ScriptEngine {
  private:
   void initContext();
 
+  static void onGcPrologue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags,
+                           void* data);
+
+  static void onGcEpilogue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags,
+                           void* data);
+
+  static size_t onNearHeapLimit(void* data, size_t currentHeapLimit, size_t initialHeapLimit);
+
+  void applyHeapLimit();
+
   Local<Value> eval(const Local<String>& script, const Local<Value>& sourceFile);
 
   v8::Local<v8::FunctionTemplate> newConstructor(
@@ -206,6 +238,8 @@ class V8Engine : public ::script::ScriptEngine {
   // WHO is your friend!!!
   friend class V8EngineScope;
 
+  friend class V8Locker;
+
   friend class V8HandleScope;
 
   friend class V8ExitEngineScope;
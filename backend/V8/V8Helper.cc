@@ -40,6 +40,9 @@ std::tuple<v8::Isolate*, v8::Local<v8::Context>> currentEngineIsolateAndContextC
 }
 
 void checkException(v8::TryCatch& tryCatch) {
+  if (tryCatch.HasTerminated()) {
+    throw Exception("script execution terminated");
+  }
   if (tryCatch.HasCaught()) {
     throw Exception(v8_backend::V8Engine::make<Local<Value>>(tryCatch.Exception()));
   }
@@ -344,6 +344,29 @@ void Local<Array>::set(size_t index, const script::Local<script::Value>& value)
 
 void Local<Array>::add(const script::Local<script::Value>& value) const { set(size(), value); }
 
+void Local<Array>::getRange(size_t start, size_t count, Local<Value>* out) const {
+  auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+
+  v8::TryCatch tryCatch(isolate);
+  for (size_t i = 0; i < count; ++i) {
+    auto ret = val_->Get(context, static_cast<uint32_t>(start + i));
+    v8_backend::checkException(tryCatch);
+    out[i] = Local<Value>(ret.ToLocalChecked());
+  }
+}
+
+void Local<Array>::setRange(size_t start, size_t count, const Local<Value>* values) const {
+  auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+
+  v8::TryCatch tryCatch(isolate);
+  for (size_t i = 0; i < count; ++i) {
+    auto ret = val_->Set(context, static_cast<uint32_t>(start + i),
+                         v8_backend::V8Engine::toV8(isolate, values[i]));
+    (void)ret;
+    v8_backend::checkException(tryCatch);
+  }
+}
+
 void Local<Array>::clear() const {
   auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
 
@@ -475,4 +498,8 @@ void Local<ByteBuffer>::commit() const {}
 
 void Local<ByteBuffer>::sync() const {}
 
+void Local<ByteBuffer>::commit(size_t, size_t) const {}
+
+void Local<ByteBuffer>::sync(size_t, size_t) const {}
+
 }  // namespace script
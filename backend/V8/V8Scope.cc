@@ -22,13 +22,25 @@
 
 namespace script::v8_backend {
 
+V8Locker::V8Locker(V8Engine& engine) {
+  if (engine.affinity_.isBound()) {
+    engine.affinity_.checkThread();
+  } else {
+    locker_.emplace(engine.isolate_);
+  }
+}
+
 V8EngineScope::V8EngineScope(V8Engine& engine, V8Engine*)
-    : locker_(engine.isolate_),
+    : locker_(engine),
       isolateScope_(engine.isolate_),
       handleScope_(engine.isolate_),
       contextScope_(engine.context_.Get(engine.isolate_)) {}
 
-V8ExitEngineScope::V8ExitEngineScope(V8Engine& engine) : unlocker_(engine.isolate_) {}
+V8ExitEngineScope::V8ExitEngineScope(V8Engine& engine) {
+  if (!engine.affinity_.isBound()) {
+    unlocker_.emplace(engine.isolate_);
+  }
+}
 
 V8HandleScope::V8HandleScope(V8Engine& engine) : handleScope_(engine.isolate_) {}
 
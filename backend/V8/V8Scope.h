@@ -17,14 +17,26 @@
 
 #pragma once
 
+#include <optional>
 #include "../../src/Reference.h"
 #include "../../src/types.h"
 #include "V8Helper.h"
 
 namespace script::v8_backend {
 
+/**
+ * v8::Locker, skipped for an engine in ThreadMode::kSingleThread.
+ * V8 requires either all or none of the accesses to an isolate to be locked.
+ */
+class V8Locker {
+  std::optional<v8::Locker> locker_;
+
+ public:
+  explicit V8Locker(V8Engine& engine);
+};
+
 class V8EngineScope {
-  v8::Locker locker_;
+  V8Locker locker_;
   v8::Isolate::Scope isolateScope_;
   v8::HandleScope handleScope_;
   v8::Context::Scope contextScope_;
@@ -36,7 +48,7 @@ class V8EngineScope {
 };
 
 class V8ExitEngineScope {
-  v8::Unlocker unlocker_;
+  std::optional<v8::Unlocker> unlocker_;
 
  public:
   explicit V8ExitEngineScope(V8Engine& engine);
@@ -49,7 +49,7 @@ bool WasmEngine::isDestroying() const { return false; }
 
 void WasmEngine::unitTestResetRegistry() {
   classDefineRegistry_.clear();
-  ScriptEngine::classDefineRegistry_.clear();
+  ScriptEngine::resetClassDefineRegistry();
 }
 
 void WasmEngine::doDeleteScriptClass(ScriptClass* scriptClass) { delete scriptClass; }
@@ -80,7 +80,7 @@ std::shared_ptr<utils::MessageQueue> WasmEngine::messageQueue() { return message
 
 void WasmEngine::gc() {}
 
-void WasmEngine::adjustAssociatedMemory(int64_t count) {}
+void WasmEngine::adjustAssociatedMemory(int64_t count) { recordAssociatedMemory(count); }
 
 ScriptLanguage WasmEngine::getLanguageType() { return ScriptLanguage::kJavaScript; }
 
@@ -922,17 +922,20 @@ CHECKED_EM_JS(bool, _ScriptX_ByteBuffer_freeSharedByteBuffer, (int val), {
 });
 
 CHECKED_EM_JS(void, _ScriptX_ByteBuffer_syncData,
-              (int val, intptr_t buffer, size_t length, bool isCommitOrSync), {
+              (int val, intptr_t buffer, size_t offset, size_t length, bool isCommitOrSync), {
   const stack = Module.SCRIPTX_STACK;
   val = stack.values[val];
 
   // only if not shared
   if (!(val instanceof Module._ScriptX_SharedByteBuffer)) {
-    let backingI8 = new Int8Array(Module.HEAPU8.buffer, buffer, length);
+    let backingI8 = new Int8Array(Module.HEAPU8.buffer, buffer + offset, length);
+    let scriptI8 = val instanceof ArrayBuffer
+        ? new Int8Array(val, offset, length)
+        : new Int8Array(val.buffer, val.byteOffset + offset, length);
     if (isCommitOrSync) {
-      Module._ScriptX_TypedArray_memcpy(backingI8, val);
+      scriptI8.set(backingI8);
     } else {
-      Module._ScriptX_TypedArray_memcpy(val, backingI8);
+      backingI8.set(scriptI8);
     }
   }
 });
@@ -1198,27 +1201,45 @@ bool ByteBufferHelper::freeSharedByteBuffer(int val) {
 }
 
 void ByteBufferHelper::commit(const Local<script::ByteBuffer> &buffer) {
-  auto &&internalState = wasm_backend::WasmEngine::refIndex(buffer);
-  auto jsBuffer = internalState.val_;
-  auto ptr = internalState.backingStore_.get();
-  // only do sync when we have 1) js array buffer 2) native buffer
-  if (jsBuffer != -1 && ptr) {
-    CHECKED_VOID_JS_CALL(wasm_backend::_ScriptX_ByteBuffer_syncData(
-        jsBuffer, reinterpret_cast<intptr_t>(ptr), buffer.byteLength(), true));
-  }
+  commit(buffer, 0, buffer.byteLength());
 }
 
 void ByteBufferHelper::sync(const Local<script::ByteBuffer> &buffer) {
+  sync(buffer, 0, buffer.byteLength());
+}
+
+namespace {
+
+void syncRange(const Local<script::ByteBuffer> &buffer, size_t byteOffset, size_t byteLength,
+               bool isCommitOrSync) {
+  auto size = buffer.byteLength();
+  if (byteOffset > size || byteLength > size - byteOffset) {
+    throw Exception("ByteBuffer range out of bounds");
+  }
+  if (byteLength == 0) return;
+
   auto &&internalState = wasm_backend::WasmEngine::refIndex(buffer);
   auto jsBuffer = internalState.val_;
   auto ptr = internalState.backingStore_.get();
   // only do sync when we have 1) js array buffer 2) native buffer
   if (jsBuffer != -1 && ptr) {
     CHECKED_VOID_JS_CALL(wasm_backend::_ScriptX_ByteBuffer_syncData(
-        jsBuffer, reinterpret_cast<intptr_t>(ptr), buffer.byteLength(), false));
+        jsBuffer, reinterpret_cast<intptr_t>(ptr), byteOffset, byteLength, isCommitOrSync));
   }
 }
 
+}  // namespace
+
+void ByteBufferHelper::commit(const Local<script::ByteBuffer> &buffer, size_t byteOffset,
+                              size_t byteLength) {
+  syncRange(buffer, byteOffset, byteLength, true);
+}
+
+void ByteBufferHelper::sync(const Local<script::ByteBuffer> &buffer, size_t byteOffset,
+                            size_t byteLength) {
+  syncRange(buffer, byteOffset, byteLength, false);
+}
+
 bool ByteBufferHelper::isSharedByteBuffer(const Local<ByteBuffer> &sharedByteBuffer) {
   auto &&internalState = wasm_backend::WasmEngine::refIndex(sharedByteBuffer);
   if (internalState.val_ == -1 && internalState.backingStore_) {
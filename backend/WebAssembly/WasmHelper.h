@@ -168,6 +168,8 @@ class ByteBufferHelper {
   static bool freeSharedByteBuffer(int val);
   static void commit(const Local<ByteBuffer>& buffer);
   static void sync(const Local<ByteBuffer>& buffer);
+  static void commit(const Local<ByteBuffer>& buffer, size_t byteOffset, size_t byteLength);
+  static void sync(const Local<ByteBuffer>& buffer, size_t byteOffset, size_t byteLength);
   static bool isSharedByteBuffer(const Local<ByteBuffer>& sharedByteBuffer);
 };
 
@@ -264,6 +264,18 @@ void Local<Array>::set(size_t index, const script::Local<script::Value>& value)
 
 void Local<Array>::add(const script::Local<script::Value>& value) const { set(size(), value); }
 
+void Local<Array>::getRange(size_t start, size_t count, Local<Value>* out) const {
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = Local<Value>(wasm_backend::Stack::arrayGet(val_, static_cast<int>(start + i)));
+  }
+}
+
+void Local<Array>::setRange(size_t start, size_t count, const Local<Value>* values) const {
+  for (size_t i = 0; i < count; ++i) {
+    wasm_backend::Stack::arraySet(val_, static_cast<int>(start + i), values[i].val_);
+  }
+}
+
 void Local<Array>::clear() const { wasm_backend::Stack::arrayClear(val_); }
 
 // ByteBuffer
@@ -282,9 +294,11 @@ ByteBufferState::ByteBufferState(ByteBufferState&& move) noexcept
     : val_(move.val_),
       backingStore_(std::move(move.backingStore_)),
       size_(move.size_),
-      type_(std::move(move.type_)) {
+      type_(std::move(move.type_)),
+      manualCommit_(move.manualCommit_) {
   move.val_ = -1;
   move.size_ = 0;
+  move.manualCommit_ = false;
 }
 
 ByteBufferState& ByteBufferState::operator=(int what) {
@@ -300,6 +314,7 @@ void ByteBufferState::reset() const {
   backingStore_.reset();
   size_ = 0;
   type_.reset();
+  manualCommit_ = false;
 }
 
 void ByteBufferState::fillBackingStore() const {
@@ -336,6 +351,7 @@ void swap(ByteBufferState& lhs, ByteBufferState& rhs) {
   std::swap(lhs.backingStore_, rhs.backingStore_);
   std::swap(lhs.size_, rhs.size_);
   std::swap(lhs.type_, rhs.type_);
+  std::swap(lhs.manualCommit_, rhs.manualCommit_);
 }
 
 }  // namespace wasm_backend
@@ -347,7 +363,9 @@ Local<ByteBuffer>::Local(InternalLocalRef val) : val_(val) {
   wasm_backend::currentEngine();
 }
 
-Local<ByteBuffer>::~Local() { commit(); }
+Local<ByteBuffer>::~Local() {
+  if (!val_.manualCommit_) commit();
+}
 
 ByteBuffer::Type Local<ByteBuffer>::getType() const {
   val_.fillTypeAndSize();
@@ -382,4 +400,14 @@ void Local<ByteBuffer>::commit() const { wasm_backend::ByteBufferHelper::commit(
 
 void Local<ByteBuffer>::sync() const { wasm_backend::ByteBufferHelper::sync(*this); }
 
+void Local<ByteBuffer>::commit(size_t byteOffset, size_t byteLength) const {
+  val_.manualCommit_ = true;
+  wasm_backend::ByteBufferHelper::commit(*this, byteOffset, byteLength);
+}
+
+void Local<ByteBuffer>::sync(size_t byteOffset, size_t byteLength) const {
+  val_.manualCommit_ = true;
+  wasm_backend::ByteBufferHelper::sync(*this, byteOffset, byteLength);
+}
+
 }  // namespace script
@@ -101,12 +101,7 @@ Local<Array> Array::newArray(size_t size) {
 
 Local<Array> Array::newArrayImpl(size_t size, const Local<Value>* args) {
   auto ret = newArray(size);
-  {
-    StackFrameScope stackFrame;
-    for (size_t i = 0; i < size; ++i) {
-      ret.set(i, args[i]);
-    }
-  }
+  ret.setRange(0, size, args);
   return ret;
 }
 
@@ -35,6 +35,8 @@ struct ByteBufferState {
   mutable std::shared_ptr<void> backingStore_;
   mutable size_t size_ = 0;
   mutable std::optional<ByteBuffer::Type> type_;
+  // set by ranged commit/sync, then the whole buffer is no longer committed on destruction
+  mutable bool manualCommit_ = false;
 
   /**
    * constructor to create ByteBuffer wrapping ArrayBuffer of SharedByteBuffer
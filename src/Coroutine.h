@@ -0,0 +1,378 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// ScriptX itself is built as C++17, the coroutine support is header only,
+// and available when the including code is compiled with C++20 coroutines.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#define SCRIPTX_FEATURE_COROUTINE
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <variant>
+#include "Engine.h"
+#include "Exception.h"
+#include "NativeConverter.hpp"
+#include "Promise.h"
+#include "Reference.h"
+#include "Scope.h"
+#include "utils/MessageQueue.h"
+
+namespace script {
+
+template <typename T = void>
+class Task;
+
+namespace internal {
+
+template <typename T>
+class TaskResult {
+  static_assert(!std::is_reference_v<T>, "Task<T&> is not supported");
+
+ public:
+  template <typename U>
+  void return_value(U&& value) {
+    result_.template emplace<1>(std::forward<U>(value));
+  }
+
+  void unhandled_exception() { result_.template emplace<2>(std::current_exception()); }
+
+  T take() {
+    if (result_.index() == 2) std::rethrow_exception(std::get<2>(result_));
+    return std::move(std::get<1>(result_));
+  }
+
+ protected:
+  std::exception_ptr exception() const {
+    return result_.index() == 2 ? std::get<2>(result_) : nullptr;
+  }
+
+  PromiseResolver::ValueFactory takeFactory() {
+    auto value = std::make_shared<T>(std::move(std::get<1>(result_)));
+    return [value]() { return TypeConverter<T>::toScript(std::move(*value)); };
+  }
+
+ private:
+  std::variant<std::monostate, T, std::exception_ptr> result_;
+};
+
+template <>
+class TaskResult<void> {
+ public:
+  void return_void() {}
+
+  void unhandled_exception() { exception_ = std::current_exception(); }
+
+  void take() {
+    if (exception_) std::rethrow_exception(exception_);
+  }
+
+ protected:
+  std::exception_ptr exception() const { return exception_; }
+
+  // resolve with null
+  PromiseResolver::ValueFactory takeFactory() { return {}; }
+
+ private:
+  std::exception_ptr exception_;
+};
+
+template <typename T>
+class TaskPromise : public TaskResult<T> {
+ public:
+  Task<T> get_return_object() noexcept;
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<TaskPromise> handle) noexcept {
+      auto& promise = handle.promise();
+      if (promise.resolver_) {
+        // a detached root task, see Task::toPromise
+        promise.settle();
+        handle.destroy();
+        return std::noop_coroutine();
+      }
+      if (promise.continuation_) {
+        return promise.continuation_;
+      }
+      return std::noop_coroutine();
+    }
+
+    void await_resume() noexcept {}
+  };
+
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+ private:
+  void settle() noexcept {
+    try {
+      if (auto e = this->exception()) {
+        try {
+          std::rethrow_exception(e);
+        } catch (const Exception& ex) {
+          resolver_->reject(ex.message());
+        } catch (const std::exception& ex) {
+          resolver_->reject(ex.what());
+        } catch (...) {
+          resolver_->reject("unknown exception in Task");
+        }
+      } else {
+        resolver_->resolve(this->takeFactory());
+      }
+    } catch (...) {
+      // the resolver rejects the promise on destroy
+    }
+  }
+
+  std::coroutine_handle<> continuation_;
+  std::shared_ptr<PromiseResolver> resolver_;
+
+  friend class Task<T>;
+};
+
+}  // namespace internal
+
+/**
+ * A lazily started coroutine, which can be returned from bound native functions (via
+ * Function::newFunction or ClassDefineBuilder), and becomes a script Promise.
+ *
+ * Locals can't be held across a suspension point (they belong to a StackFrameScope),
+ * hold a Global instead.
+ *
+ * \code
+ * Task<std::string> query(std::string sql) {
+ *   auto rows = co_await database.asyncQuery(sql);  // any awaitable, may resume on another thread
+ *   co_await resumeOnEngine(engine);                // back to engine thread, EngineScope entered
+ *   co_return format(rows);
+ * }
+ *
+ * engine->set("query", Function::newFunction(query));
+ * // js: query("select 1").then(...)
+ * \endcode
+ *
+ * note: only available when compiled with C++20 coroutines, test SCRIPTX_FEATURE_COROUTINE.
+ * note: the script Promise requires a JavaScript backend.
+ */
+template <typename T>
+class Task {
+ public:
+  using promise_type = internal::TaskPromise<T>;
+
+  Task(Task&& move) noexcept : handle_(std::exchange(move.handle_, {})) {}
+
+  Task& operator=(Task&& move) noexcept {
+    if (this != &move) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(move.handle_, {});
+    }
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+
+  Task& operator=(const Task&) = delete;
+
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  /**
+   * start the task, and bind it's result to a new script Promise.
+   * called in EngineScope, the task runs synchronously until it first suspends.
+   */
+  Local<Object> toPromise() && {
+    auto [promise, resolver] = Promise::newPromise();
+    auto handle = std::exchange(handle_, {});
+    handle.promise().resolver_ = std::move(resolver);
+    handle.resume();
+    return promise;
+  }
+
+  /**
+   * await another Task in a coroutine.
+   */
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      std::coroutine_handle<promise_type> handle;
+
+      bool await_ready() noexcept { return !handle || handle.done(); }
+
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+        handle.promise().continuation_ = continuation;
+        return handle;
+      }
+
+      T await_resume() { return handle.promise().take(); }
+    };
+    return Awaiter{handle_};
+  }
+
+ private:
+  explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+
+  friend promise_type;
+};
+
+template <typename T>
+Task<T> internal::TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+/**
+ * co_await resumeOnEngine(engine);
+ *
+ * resume the coroutine from the engine's MessageQueue, with EngineScope entered.
+ * @throw Exception if the message can't be posted or is dropped (queue shutdown or engine
+ * destroyed), the coroutine is then resumed on the posting or dropping thread, without
+ * EngineScope.
+ */
+inline auto resumeOnEngine(ScriptEngine* engine) {
+  enum Phase { kPosting, kPosted, kRunning, kDiscarded };
+
+  // shared with the message, the awaiter is gone once the coroutine is resumed
+  struct State {
+    std::coroutine_handle<> handle;
+    ScriptEngine* engine;
+    std::atomic<int> phase{kPosting};
+  };
+
+  struct Awaiter {
+    std::shared_ptr<State> state;
+
+    bool await_ready() noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      auto state = this->state;
+      state->handle = handle;
+
+      utils::Message msg(
+          [](utils::Message& msg) {
+            auto& state = **static_cast<std::shared_ptr<State>*>(msg.ptr0);
+            state.phase.store(kRunning, std::memory_order_release);
+            EngineScope scope(state.engine);
+            state.handle.resume();
+          },
+          [](utils::Message& msg) {
+            std::unique_ptr<std::shared_ptr<State>> holder(
+                static_cast<std::shared_ptr<State>*>(msg.ptr0));
+            auto& state = **holder;
+            auto phase = state.phase.load(std::memory_order_acquire);
+            while (phase != kRunning &&
+                   !state.phase.compare_exchange_weak(phase, kDiscarded,
+                                                      std::memory_order_acq_rel)) {
+            }
+            // while posting, await_suspend resumes the coroutine
+            if (phase == kPosted) state.handle.resume();
+          });
+      msg.ptr0 = new std::shared_ptr<State>(state);
+      msg.tag = state->engine;
+      msg.name = "script::resumeOnEngine";
+      // on failure the message is cleaned up by the queue
+      auto posted = state->engine->messageQueue()->postMessage(msg) != 0;
+      if (!posted) state->phase.store(kDiscarded, std::memory_order_release);
+
+      int phase = kPosting;
+      if (posted &&
+          state->phase.compare_exchange_strong(phase, kPosted, std::memory_order_acq_rel)) {
+        return true;
+      }
+      // already resumed on the engine thread, or resume now to throw
+      return phase == kRunning;
+    }
+
+    void await_resume() {
+      if (state->phase.load(std::memory_order_acquire) == kDiscarded) {
+        throw Exception("resumeOnEngine: message dropped, engine destroyed or queue shutdown");
+      }
+    }
+  };
+  auto state = std::make_shared<State>();
+  state->engine = engine;
+  return Awaiter{std::move(state)};
+}
+
+/**
+ * auto value = co_await awaitPromise(promise);
+ *
+ * await a script promise in a coroutine running on the engine thread, in EngineScope.
+ * @return the fulfilled value held by a Global, resumed with EngineScope entered.
+ * @throw Exception with the message of the rejected reason.
+ */
+inline auto awaitPromise(const Local<Value>& promise) {
+  struct State {
+    Global<Value> value;
+    std::exception_ptr error;
+  };
+
+  struct Awaiter {
+    Global<Value> promise;
+    std::shared_ptr<State> state;
+
+    bool await_ready() noexcept { return promise.isEmpty(); }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+      auto local = promise.get().asObject();
+      promise.reset();
+
+      auto onFulfilled = Function::newFunction([state = state, handle](const Local<Value>& value) {
+        state->value = value;
+        handle.resume();
+      });
+      auto onRejected = Function::newFunction([state = state, handle](const Local<Value>& reason) {
+        state->error = std::make_exception_ptr(Exception(Exception(reason).message()));
+        handle.resume();
+      });
+      local.get("then").asFunction().call(local, onFulfilled, onRejected);
+    }
+
+    Global<Value> await_resume() {
+      if (state->error) std::rethrow_exception(state->error);
+      return std::move(state->value);
+    }
+  };
+
+  auto state = std::make_shared<State>();
+  if (!Promise::isPromise(promise)) {
+    // ready without suspending
+    state->value = promise;
+    return Awaiter{Global<Value>(), std::move(state)};
+  }
+  return Awaiter{Global<Value>(promise), std::move(state)};
+}
+
+}  // namespace script
+
+namespace script::converter {
+
+template <typename T>
+struct Converter<Task<T>> {
+  static Local<Value> toScript(Task<T>&& task) { return std::move(task).toPromise(); }
+};
+
+}  // namespace script::converter
+
+#endif
@@ -16,21 +16,174 @@
  */
 
 #include <ScriptX/ScriptX.h>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
 
 namespace script {
 
+namespace internal {
+
+size_t nextClassSlot() {
+  static std::atomic<size_t> next{0};
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+class ExecutionWatchdog {
+  using Entry = std::pair<std::chrono::steady_clock::time_point, ExecutionTimeout*>;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::set<Entry> timeouts_;
+
+  ExecutionWatchdog() {
+    std::thread([this]() { run(); }).detach();
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      if (timeouts_.empty()) {
+        condition_.wait(lock);
+        continue;
+      }
+      auto first = timeouts_.begin();
+      if (std::chrono::steady_clock::now() < first->first) {
+        condition_.wait_until(lock, first->first);
+        continue;
+      }
+      // the timeout object is alive while it's in the set
+      auto timeout = first->second;
+      timeouts_.erase(first);
+      timeout->timedOut_.store(true, std::memory_order_release);
+      timeout->engine_->terminateExecution();
+    }
+  }
+
+ public:
+  static ExecutionWatchdog& instance() {
+    // never destroyed, the thread runs until the process exits
+    static auto watchdog = new ExecutionWatchdog();
+    return *watchdog;
+  }
+
+  void add(ExecutionTimeout* timeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timeouts_.emplace(timeout->deadline_, timeout).first;
+    if (it == timeouts_.begin()) {
+      condition_.notify_one();
+    }
+  }
+
+  void remove(ExecutionTimeout* timeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeouts_.erase({timeout->deadline_, timeout});
+  }
+};
+
+}  // namespace internal
+
+ExecutionTimeout::ExecutionTimeout(ScriptEngine* engine, std::chrono::nanoseconds timeout)
+    : engine_(engine),
+      deadline_(std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout)) {
+  internal::ExecutionWatchdog::instance().add(this);
+}
+
+ExecutionTimeout::~ExecutionTimeout() {
+  internal::ExecutionWatchdog::instance().remove(this);
+  if (isTimedOut()) {
+    // don't let the termination leak to the next script
+    engine_->cancelTerminateExecution();
+  }
+}
+
 void ScriptEngine::setData(std::shared_ptr<void> arbitraryData) {
   userData_ = std::move(arbitraryData);
 }
 
-void ScriptEngine::destroyUserData() { userData_.reset(); }
+void ScriptEngine::destroyUserData() {
+  userData_.reset();
+  if (!keptReferences_) return;
+
+  std::vector<std::shared_ptr<void>> references;
+  {
+    std::lock_guard<std::mutex> lock(keptReferences_->mutex);
+    keptReferences_->released = true;
+    references.swap(keptReferences_->references);
+  }
+  EngineScope scope(this);
+  references.clear();
+}
+
+const std::shared_ptr<internal::KeptReferences>& ScriptEngine::keptReferences() {
+  if (!keptReferences_) {
+    keptReferences_ = std::make_shared<internal::KeptReferences>();
+  }
+  return keptReferences_;
+}
+
+bool internal::KeptReferences::keep(std::shared_ptr<void> reference) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (released) return false;
+  references.push_back(std::move(reference));
+  return true;
+}
+
+EngineStats ScriptEngine::getStats() {
+  EngineStats stats;
+  stats.usedHeapSize = getHeapSize();
+  stats.totalHeapSize = stats.usedHeapSize;
+  stats.externalMemory = associatedMemory_;
+  stats.gcCount = gcCount_;
+  stats.gcPauseTime = gcPauseTime_;
+  stats.registeredClassCount = classDefineRegistry_.size() + staticClassDefineRegistry_.size();
+
+  if (auto queue = messageQueue()) {
+    auto queueStats = queue->stats();
+    stats.messageQueueDepth = queueStats.messageCount;
+    stats.oldestMessageAge = queueStats.oldestDueMessageAge;
+  }
+  return stats;
+}
+
+void ScriptEngine::recordGcBegin() noexcept {
+  if (gcCallback_) {
+    try {
+      gcCallback_(GcPhase::kBegin, std::chrono::nanoseconds(0));
+    } catch (...) {
+    }
+  }
+}
+
+void ScriptEngine::recordGcEnd(std::chrono::nanoseconds pauseTime) noexcept {
+  ++gcCount_;
+  gcPauseTime_ += pauseTime;
+  if (gcCallback_) {
+    try {
+      gcCallback_(GcPhase::kEnd, pauseTime);
+    } catch (...) {
+    }
+  }
+}
+
+size_t ScriptEngine::nearHeapLimit(size_t heapLimit, size_t usedHeapSize) noexcept {
+  if (!nearHeapLimitCallback_) return 0;
+  try {
+    auto newLimit = nearHeapLimitCallback_(heapLimit, usedHeapSize);
+    return newLimit > heapLimit ? newLimit : 0;
+  } catch (...) {
+    return 0;
+  }
+}
 
 void ScriptEngine::registerNativeClass(const script::NativeRegister& nativeRegister) {
   nativeRegister.registerNativeClass(this);
 }
 
 void ScriptEngine::registerNativeClassInternal(
-    internal::TypeIndex typeIndex, const internal::ClassDefineState* classDefine,
+    internal::TypeIndex typeIndex, size_t classSlot, const internal::ClassDefineState* classDefine,
     script::ScriptClass* (*instanceTypeToScriptClass)(void*)) {
   if ((!classDefine->hasInstanceDefine() &&
        staticClassDefineRegistry_.find(classDefine) != staticClassDefineRegistry_.end()) ||
@@ -43,11 +196,29 @@ void ScriptEngine::registerNativeClassInternal(
     staticClassDefineRegistry_.emplace(classDefine);
   } else {
     classDefineRegistry_.emplace(typeIndex, classDefine);
+    if (classSlot >= classDefineSlots_.size()) {
+      classDefineSlots_.resize(classSlot + 1);
+    }
+    classDefineSlots_[classSlot] = {classDefine, typeIndex};
   }
 }
 
+void ScriptEngine::resetClassDefineRegistry() {
+  classDefineRegistry_.clear();
+  staticClassDefineRegistry_.clear();
+  classDefineSlots_.clear();
+}
+
 const internal::ClassDefineState* ScriptEngine::getClassDefineInternal(
-    internal::TypeIndex typeIndex) const {
+    size_t classSlot, internal::TypeIndex typeIndex) const {
+  if (classSlot < classDefineSlots_.size()) {
+    auto& slot = classDefineSlots_[classSlot];
+    if (slot.classDefine && slot.typeIndex == typeIndex) {
+      return slot.classDefine;
+    }
+  }
+
+  // the slot of a type may differ across shared libraries, and belong to another type
   auto it = classDefineRegistry_.find(typeIndex);
   if (it == classDefineRegistry_.end()) {
     throw Exception(std::string("ClassDefine is not registered"));
@@ -17,10 +17,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include "Reference.h"
 #include "Value.h"
 #include "types.h"
@@ -29,12 +36,124 @@
 
 namespace script {
 
+namespace internal {
+class ExecutionWatchdog;
+
+/**
+ * native objects holding script references that are dropped off the engine thread,
+ * they are released on the engine thread when the engine is destroyed.
+ * see ScriptEngine::keptReferences.
+ */
+struct KeptReferences {
+  std::mutex mutex;
+  bool released = false;
+  std::vector<std::shared_ptr<void>> references;
+
+  /**
+   * thread safe.
+   * @return false if the engine is already destroyed, reference is released on this thread.
+   */
+  bool keep(std::shared_ptr<void> reference);
+};
+
+}  // namespace internal
+
+/**
+ * runtime metrics of a ScriptEngine, see ScriptEngine::getStats.
+ * fields not supported by the backend are left 0.
+ */
+struct EngineStats {
+  /** bytes of script heap in use */
+  size_t usedHeapSize = 0;
+  /** bytes of script heap reserved, >= usedHeapSize */
+  size_t totalHeapSize = 0;
+  /**
+   * net bytes reported by ScriptEngine::adjustAssociatedMemory,
+   * plus live ArrayBuffers of a V8 isolate created by ScriptX
+   */
+  int64_t externalMemory = 0;
+
+  /**
+   * garbage collections and the total time spent in them.
+   * V8 counts every collection, the other backends count only ScriptEngine::gc calls.
+   */
+  uint64_t gcCount = 0;
+  std::chrono::nanoseconds gcPauseTime{0};
+
+  /** live (non-empty) Global and Weak references */
+  size_t globalCount = 0;
+  size_t weakCount = 0;
+
+  /** ClassDefines registered by registerNativeClass */
+  size_t registeredClassCount = 0;
+
+  /** messages in messageQueue(), including delayed ones */
+  size_t messageQueueDepth = 0;
+  /** how long the earliest due message has been waiting past its due time */
+  std::chrono::nanoseconds oldestMessageAge{0};
+
+  /**
+   * microtasks (promise jobs) drained by ScriptX on the MessageQueue, QuickJs only.
+   * microtaskDelay is the longest wait from a drain being scheduled to it running.
+   */
+  uint64_t microtaskCount = 0;
+  uint64_t microtaskDrainCount = 0;
+  std::chrono::nanoseconds microtaskTime{0};
+  std::chrono::nanoseconds microtaskDelay{0};
+};
+
 class ScriptEngine {
  protected:
   std::unordered_map<internal::TypeIndex, const internal::ClassDefineState*> classDefineRegistry_{};
   std::unordered_set<const internal::ClassDefineState*> staticClassDefineRegistry_{};
+  struct ClassDefineSlot {
+    const internal::ClassDefineState* classDefine = nullptr;
+    // checked on lookup, the slot of a type may differ across shared libraries
+    std::optional<internal::TypeIndex> typeIndex{};
+  };
+  // the same ClassDefines as classDefineRegistry_, indexed by internal::classSlotOf
+  std::vector<ClassDefineSlot> classDefineSlots_{};
   std::shared_ptr<void> userData_{};
 
+ public:
+  enum class GcPhase { kBegin, kEnd };
+
+  /**
+   * passed to the engine constructor (V8, QuickJs and Lua backends).
+   *
+   * kMultiThread: the engine can be used from any thread, EngineScope takes the engine lock.
+   * kSingleThread: the engine is bound to the thread constructing it, and takes no lock on
+   * EngineScope enter/exit. Using it (including destroy and getStats) from another thread fails
+   * an assert in debug builds, and is undefined behavior in release builds.
+   */
+  enum class ThreadMode { kMultiThread, kSingleThread };
+
+  /**
+   * @param phase begin or end of a garbage collection
+   * @param pauseTime time spent in this collection, 0 for GcPhase::kBegin
+   *
+   * note: called inside the garbage collector, must not call any ScriptX API.
+   */
+  using GcCallback = std::function<void(GcPhase phase, std::chrono::nanoseconds pauseTime)>;
+
+  /**
+   * @param heapLimit current heap limit in bytes
+   * @param usedHeapSize bytes of script heap in use
+   * @return a new limit greater than heapLimit to let the script go on,
+   * or 0 to stop it (see ScriptEngine::setHeapLimit).
+   *
+   * note: called inside the allocator or garbage collector, must not call any ScriptX API.
+   */
+  using NearHeapLimitCallback = std::function<size_t(size_t heapLimit, size_t usedHeapSize)>;
+
+ private:
+  int64_t associatedMemory_ = 0;
+  uint64_t gcCount_ = 0;
+  std::chrono::nanoseconds gcPauseTime_{0};
+  GcCallback gcCallback_{};
+  NearHeapLimitCallback nearHeapLimitCallback_{};
+  std::shared_ptr<internal::KeptReferences> keptReferences_{};
+
  public:
   explicit ScriptEngine(std::shared_ptr<utils::MessageQueue> messageQueue = {}) {}
 
@@ -210,6 +329,64 @@ class ScriptEngine {
    */
   virtual void adjustAssociatedMemory(int64_t count) { SCRIPTX_UNUSED(count); }
 
+  /**
+   * Collect runtime metrics of this engine, cheap enough to be polled periodically
+   * (never triggers gc), enters EngineScope if necessary.
+   *
+   * note: like any other engine API, it's called on the engine's thread: any thread holding
+   * the engine for kMultiThread (EngineScope waits for the running script), only the owning
+   * thread for kSingleThread. To monitor from another thread, post a message to the engine's
+   * MessageQueue, or read MessageQueue::stats() which is thread safe.
+   */
+  virtual EngineStats getStats();
+
+  /**
+   * Limit the memory the script heap can use, in bytes, 0 for no limit.
+   * When the limit is reached, the NearHeapLimitCallback may raise it,
+   * otherwise the running script fails instead of crashing the process:
+   * V8 terminates the execution, QuickJs and Lua throw an out of memory error.
+   *
+   * note: V8 can only lower the limit of an isolate: it returns false for 0 or for a limit
+   * above the current one, and the limit is left unchanged. Only the NearHeapLimitCallback
+   * can raise it.
+   * @return false if not supported by the backend, or the limit can't be set.
+   */
+  virtual bool setHeapLimit(size_t bytes) {
+    SCRIPTX_UNUSED(bytes);
+    return false;
+  }
+
+  /**
+   * Stop the script running in this engine as soon as possible, can be called from any thread.
+   * The script can't catch the termination, the interrupted eval or Function::call throws
+   * Exception. If no script is running, the next one may be terminated.
+   * Once unwound to the outermost native caller, the engine runs scripts normally again.
+   *
+   * note: native code called by the script is not interrupted.
+   * note: not supported by the Lua backend built with LuaJIT.
+   * @return false if not supported by the backend.
+   */
+  virtual bool terminateExecution() { return false; }
+
+  /**
+   * Cancel a terminateExecution which hasn't taken effect yet, can be called from any thread.
+   */
+  virtual void cancelTerminateExecution() {}
+
+  /**
+   * @param callback called on begin and end of each garbage collection counted
+   * by EngineStats::gcCount, pass empty to remove.
+   */
+  void setGcCallback(GcCallback callback) { gcCallback_ = std::move(callback); }
+
+  /**
+   * @param callback called when the heap limit set by setHeapLimit is reached,
+   * pass empty to remove.
+   */
+  void setNearHeapLimitCallback(NearHeapLimitCallback callback) {
+    nearHeapLimitCallback_ = std::move(callback);
+  }
+
   /**
    * @return script language the engine supported
    */
@@ -237,15 +414,52 @@ class ScriptEngine {
    */
   virtual ~ScriptEngine() = default;
 
+  /**
+   * destroy the user data, and release keptReferences on the engine thread.
+   */
   void destroyUserData();
 
+ public:
+  /**
+   * the store of references released when this engine is destroyed, shared with objects that
+   * may outlive the engine. Must be called with EngineScope entered.
+   */
+  const std::shared_ptr<internal::KeptReferences>& keptReferences();
+
+ protected:
+  /**
+   * to be called by backend's adjustAssociatedMemory, accounted in EngineStats::externalMemory.
+   */
+  void recordAssociatedMemory(int64_t count) noexcept { associatedMemory_ += count; }
+
+  /**
+   * forget all registered ClassDefines, the backend resets its own registry.
+   */
+  void resetClassDefineRegistry();
+
+  /**
+   * to be called by backend before and after each garbage collection,
+   * accounted in EngineStats::gcCount and gcPauseTime.
+   */
+  void recordGcBegin() noexcept;
+
+  void recordGcEnd(std::chrono::nanoseconds pauseTime) noexcept;
+
+  /**
+   * to be called by backend when the heap limit is reached.
+   * @return the new limit from NearHeapLimitCallback, or 0 if not raised.
+   */
+  size_t nearHeapLimit(size_t heapLimit, size_t usedHeapSize) noexcept;
+
   // non-template version of ClassDefine related api
  private:
   void registerNativeClassInternal(
-      internal::TypeIndex typeIndex, const internal::ClassDefineState* classDefine,
+      internal::TypeIndex typeIndex, size_t classSlot,
+      const internal::ClassDefineState* classDefine,
       ScriptClass* (*instanceTypeToScriptClass)(void* instancePointer));
 
-  const internal::ClassDefineState* getClassDefineInternal(internal::TypeIndex typeIndex) const;
+  const internal::ClassDefineState* getClassDefineInternal(size_t classSlot,
+                                                           internal::TypeIndex typeIndex) const;
 
   // implemented by backend
  protected:
@@ -269,6 +483,39 @@ class ScriptEngine {
                                          const internal::ClassDefineState* classDefine) = 0;
 };
 
+/**
+ * Terminate (ScriptEngine::terminateExecution) any script still running in the engine
+ * when the timeout expires, within the lifetime of this object.
+ * A watchdog thread shared by all engines keeps the time, scripts are not slowed down.
+ *
+ * \code
+ * {
+ *   ExecutionTimeout timeout(engine, std::chrono::milliseconds(100));
+ *   engine->eval(untrustedScript);  // throws Exception if it runs longer than 100ms
+ * }
+ * \endcode
+ */
+class ExecutionTimeout {
+ public:
+  ExecutionTimeout(ScriptEngine* engine, std::chrono::nanoseconds timeout);
+
+  ~ExecutionTimeout();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(ExecutionTimeout);
+
+  /**
+   * @return whether the timeout has expired and the engine was asked to terminate.
+   */
+  bool isTimedOut() const { return timedOut_.load(std::memory_order_acquire); }
+
+ private:
+  ScriptEngine* engine_;
+  std::chrono::steady_clock::time_point deadline_;
+  std::atomic_bool timedOut_{false};
+
+  friend class internal::ExecutionWatchdog;
+};
+
 /**
  * ScriptEngine don't have public destructor, use ScriptEngine::Deleter.
  */
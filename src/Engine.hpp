@@ -30,7 +30,8 @@ namespace script {
 template <typename T>
 void ScriptEngine::registerNativeClass(const ClassDefine<T>& classDefine) {
   return registerNativeClassInternal(
-      internal::typeIndexOf<T>(), static_cast<const internal::ClassDefineState*>(&classDefine),
+      internal::typeIndexOf<T>(), internal::classSlotOf<T>(),
+      static_cast<const internal::ClassDefineState*>(&classDefine),
       [](void* instancePointer) {
         return static_cast<ScriptClass*>(static_cast<T*>(instancePointer));
       });
@@ -39,7 +40,7 @@ void ScriptEngine::registerNativeClass(const ClassDefine<T>& classDefine) {
 template <typename T>
 const ClassDefine<T>& ScriptEngine::getClassDefine() const {
   static_assert(!std::is_same_v<void, T>);
-  auto state = getClassDefineInternal(internal::typeIndexOf<T>());
+  auto state = getClassDefineInternal(internal::classSlotOf<T>(), internal::typeIndexOf<T>());
   return *static_cast<const ClassDefine<T>*>(state);
 }
 
@@ -682,6 +682,10 @@ inline Local<Array> Array::newArray(const std::initializer_list<Local<Value>>& e
   return newArrayImpl(elements.size(), elements.begin());
 }
 
+inline Local<Array> Array::newArray(const Local<Value>* elements, size_t size) {
+  return newArrayImpl(size, elements);
+}
+
 template <typename... T>
 inline internal::type_t<Local<Array>, decltype(&internal::TypeConverter<T>::toScript)...> Array::of(
     T&&... args) {
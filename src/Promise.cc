@@ -0,0 +1,173 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Promise.h"
+#include <ScriptX/ScriptX.h>
+
+namespace script {
+
+struct PromiseResolver::State {
+  ScriptEngine* engine = nullptr;
+  std::shared_ptr<utils::MessageQueue> queue;
+  // keeps the State when the settlement is discarded, the Globals must not be destroyed off the
+  // engine thread
+  std::shared_ptr<internal::KeptReferences> kept;
+  // reset once settled, and by the engine when it's destroyed
+  Global<Function> resolve;
+  Global<Function> reject;
+};
+
+struct PromiseResolver::Settlement {
+  std::shared_ptr<State> state;
+  bool fulfill;
+  ValueFactory factory;
+  bool handled = false;
+
+  static void handle(utils::Message& msg) {
+    auto settlement = static_cast<Settlement*>(msg.ptr0);
+    settlement->handled = true;
+    auto& state = *settlement->state;
+    if (state.resolve.isEmpty()) {
+      // engine destroyed
+      return;
+    }
+
+    EngineScope scope(state.engine);
+    try {
+      auto value = settlement->factory ? settlement->factory() : Local<Value>();
+      (settlement->fulfill ? state.resolve : state.reject).get().call({}, value);
+    } catch (const Exception& e) {
+      state.reject.get().call({}, e.exception());
+    }
+    state.resolve.reset();
+    state.reject.reset();
+  }
+
+  static void cleanup(utils::Message& msg) {
+    std::unique_ptr<Settlement> settlement(static_cast<Settlement*>(msg.ptr0));
+    if (!settlement->handled) {
+      // discarded, maybe on another thread, the engine releases the State.
+      // if the engine is already destroyed, the Globals are reset by it.
+      auto kept = settlement->state->kept;
+      kept->keep(std::move(settlement->state));
+    }
+  }
+};
+
+namespace {
+
+Local<Function> promiseConstructor() {
+  auto ctor = EngineScope::currentEngine()->get("Promise");
+  if (!ctor.isFunction()) {
+    throw Exception("Promise is not supported by current engine");
+  }
+  return ctor.asFunction();
+}
+
+}  // namespace
+
+Promise::Capability Promise::newPromise() {
+  auto engine = EngineScope::currentEngine();
+  auto ctor = promiseConstructor();
+
+  auto state = std::make_shared<PromiseResolver::State>();
+  state->engine = engine;
+  state->queue = engine->messageQueue();
+  state->kept = engine->keptReferences();
+
+  // the executor is called synchronously by the Promise constructor
+  auto executor = Function::newFunction([&state](const Arguments& args) -> Local<Value> {
+    if (args.size() < 2 || !args[0].isFunction() || !args[1].isFunction()) {
+      throw Exception("invalid Promise executor arguments");
+    }
+    state->resolve = args[0].asFunction();
+    state->reject = args[1].asFunction();
+    return {};
+  });
+
+  auto promise = Object::newObject(ctor, executor);
+  if (state->resolve.isEmpty()) {
+    throw Exception("Promise constructor didn't call the executor");
+  }
+  return {promise, std::shared_ptr<PromiseResolver>(new PromiseResolver(std::move(state)))};
+}
+
+bool Promise::isPromise(const Local<Value>& value) {
+  return value.isObject() && value.asObject().get("then").isFunction();
+}
+
+std::future<SerializedValue> Promise::toFuture(const Local<Value>& promise) {
+  auto result = std::make_shared<std::promise<SerializedValue>>();
+  auto future = result->get_future();
+
+  if (!isPromise(promise)) {
+    result->set_value(SerializedValue::serialize(promise));
+    return future;
+  }
+
+  auto onFulfilled = Function::newFunction([result](const Local<Value>& value) {
+    try {
+      result->set_value(SerializedValue::serialize(value));
+    } catch (const Exception& e) {
+      result->set_exception(std::make_exception_ptr(Exception(e.message())));
+    }
+  });
+
+  auto onRejected = Function::newFunction([result](const Local<Value>& reason) {
+    // keep only the message, the reason belongs to this engine
+    result->set_exception(std::make_exception_ptr(Exception(Exception(reason).message())));
+  });
+
+  auto object = promise.asObject();
+  object.get("then").asFunction().call(object, onFulfilled, onRejected);
+  return future;
+}
+
+PromiseResolver::PromiseResolver(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+PromiseResolver::~PromiseResolver() {
+  settle(false,
+         []() { return Exception("PromiseResolver destroyed without settling").exception(); });
+}
+
+bool PromiseResolver::resolve(ValueFactory factory) { return settle(true, std::move(factory)); }
+
+bool PromiseResolver::resolve(SerializedValue value) {
+  return settle(true, [value = std::move(value)]() { return value.deserialize(); });
+}
+
+bool PromiseResolver::reject(ValueFactory factory) { return settle(false, std::move(factory)); }
+
+bool PromiseResolver::reject(std::string message) {
+  return settle(false,
+                [message = std::move(message)]() { return Exception(message).exception(); });
+}
+
+bool PromiseResolver::settle(bool fulfill, ValueFactory factory) {
+  if (settled_.exchange(true, std::memory_order_acq_rel)) {
+    return false;
+  }
+
+  utils::Message msg(Settlement::handle, Settlement::cleanup);
+  msg.ptr0 = new Settlement{state_, fulfill, std::move(factory)};
+  msg.tag = state_->engine;
+  msg.name = "PromiseResolver::settle";
+  // on failure the message is cleaned up by the queue
+  return state_->queue->postMessage(msg) != 0;
+}
+
+}  // namespace script
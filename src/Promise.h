@@ -0,0 +1,129 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include "Reference.h"
+#include "SerializedValue.h"
+#include "foundation.h"
+
+namespace script {
+
+class PromiseResolver;
+
+/**
+ * Create and await script promises from C++, only available for JavaScript backends.
+ *
+ * \code
+ * // in EngineScope
+ * auto [promise, resolver] = Promise::newPromise();
+ *
+ * std::thread([resolver = resolver]() {
+ *   auto content = readFile();
+ *   // marshalled to the engine's MessageQueue
+ *   resolver->resolve([content]() { return String::newString(content); });
+ * }).detach();
+ *
+ * return promise;
+ * \endcode
+ */
+class Promise {
+ public:
+  struct Capability {
+    Local<Object> promise;
+    std::shared_ptr<PromiseResolver> resolver;
+  };
+
+  /**
+   * create a pending promise in current EngineScope.
+   * @throw Exception if current engine doesn't support Promise.
+   */
+  static Capability newPromise();
+
+  /**
+   * @return if value is a thenable (has a "then" function).
+   */
+  static bool isPromise(const Local<Value>& value);
+
+  /**
+   * await a promise (or any value) in current EngineScope.
+   * The result is serialized when the promise is fulfilled, if it's rejected the future throws
+   * an Exception holding the message of the reason.
+   *
+   * note: the future is only fulfilled when the engine runs its pending jobs, so never block
+   * the engine's thread on it.
+   */
+  static std::future<SerializedValue> toFuture(const Local<Value>& promise);
+};
+
+/**
+ * Settle a promise created by Promise::newPromise().
+ *
+ * All methods can be called on any thread without EngineScope. The settlement is posted to the
+ * engine's MessageQueue, and takes effect when the message is handled.
+ * Only the first call to resolve/reject takes effect.
+ *
+ * If the resolver is destroyed without settling, the promise is rejected.
+ */
+class PromiseResolver {
+ public:
+  /**
+   * create the settled value, called on the engine thread with EngineScope entered.
+   * If it throws an Exception, the promise is rejected with it.
+   */
+  using ValueFactory = std::function<Local<Value>()>;
+
+  ~PromiseResolver();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(PromiseResolver);
+
+  /**
+   * @return false if already settled or the engine's MessageQueue is shutdown.
+   */
+  bool resolve(ValueFactory factory);
+
+  bool resolve(SerializedValue value);
+
+  bool reject(ValueFactory factory);
+
+  /**
+   * reject with an error created by Exception(message).
+   */
+  bool reject(std::string message);
+
+  bool isSettled() const { return settled_.load(std::memory_order_acquire); }
+
+ private:
+  struct State;
+  struct Settlement;
+
+  explicit PromiseResolver(std::shared_ptr<State> state);
+
+  bool settle(bool fulfill, ValueFactory factory);
+
+  std::shared_ptr<State> state_;
+  std::atomic_bool settled_{false};
+
+  friend class Promise;
+};
+
+}  // namespace script
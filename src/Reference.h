@@ -528,6 +528,50 @@ class Local<Array> {
 
   void add(const Local<Value>& value) const;
 
+  /**
+   * batch version of get, read [start, start + count) into out.
+   * it's cheaper than calling get() in a loop, since the backend only resolve its state once.
+   *
+   * @param out must have room for at least count elements.
+   */
+  void getRange(size_t start, size_t count, Local<Value>* out) const;
+
+  /**
+   * helper method to read [start, start + count) into a vector.
+   */
+  std::vector<Local<Value>> getRange(size_t start, size_t count) const {
+    std::vector<Local<Value>> ret(count);
+    getRange(start, count, ret.data());
+    return ret;
+  }
+
+  /**
+   * batch version of set, write values into [start, start + count).
+   */
+  void setRange(size_t start, size_t count, const Local<Value>* values) const;
+
+  void setRange(size_t start, const std::vector<Local<Value>>& values) const {
+    setRange(start, values.size(), values.data());
+  }
+
+  void setRange(size_t start, const std::initializer_list<Local<Value>>& values) const {
+    setRange(start, values.size(), values.begin());
+  }
+
+  /**
+   * batch version of add, append values to the end of array.
+   * size() is only read once.
+   */
+  void addRange(size_t count, const Local<Value>* values) const { setRange(size(), count, values); }
+
+  void addRange(const std::vector<Local<Value>>& values) const {
+    addRange(values.size(), values.data());
+  }
+
+  void addRange(const std::initializer_list<Local<Value>>& values) const {
+    addRange(values.size(), values.begin());
+  }
+
   void clear() const;
 
   SPECIALIZE_NON_VALUE(Array)
@@ -626,6 +670,22 @@ class Local<ByteBuffer> {
    */
   void sync() const;
 
+  /**
+   * like commit(), but only copy byteLength bytes starting at byteOffset,
+   * so a small change to a large non-shared ByteBuffer costs no more than its size.
+   * the range must be within byteLength().
+   *
+   * note: once called, the non-shared ByteBuffer is not committed as a whole when this Local is
+   * destroyed, the caller commits what it changes.
+   */
+  void commit(size_t byteOffset, size_t byteLength) const;
+
+  /**
+   * like sync(), but only copy byteLength bytes starting at byteOffset.
+   * the range must be within byteLength(), and the same note as commit(size_t, size_t) applies.
+   */
+  void sync(size_t byteOffset, size_t byteLength) const;
+
   SPECIALIZE_NON_VALUE(ByteBuffer);
 };
 
@@ -24,8 +24,7 @@ SCRIPTX_THREAD_LOCAL(EngineScope*, current_);
 
 EngineScope::EngineScope(ScriptEngine& engine) : EngineScope(&engine) {}
 
-EngineScope::EngineScope(script::ScriptEngine* engine)
-    : EngineScope(internal::scriptDynamicCast<EngineImpl*>(engine)) {}
+EngineScope::EngineScope(script::ScriptEngine* engine) : EngineScope(toEngineImpl(engine)) {}
 
 EngineScope::EngineScope(EngineImpl& engine) : EngineScope(&engine) {}
 
@@ -39,9 +38,22 @@ EngineScope::EngineScope(EngineImpl* engine)
 
 static inline EngineScope*& currentScope() { return internal::getThreadLocal(current_); }
 
+EngineScope::EngineImpl* EngineScope::toEngineImpl(ScriptEngine* engine) {
+  auto current = currentScope();
+  if (current && current->engine_ && static_cast<ScriptEngine*>(current->engine_) == engine) {
+    return current->engine_;
+  }
+  return internal::scriptDynamicCast<EngineImpl*>(engine);
+}
+
 EngineScope::EngineScope(EngineScope::InternalEnterEngine, EngineImpl* engine, bool needEnter)
-    : needEnter_(false), engineScopeImpl_(), engine_(engine), prev_(currentScope()) {
+    : needEnter_(false), engineScopeImpl_(), engine_(engine), prev_(nullptr) {
+  // one thread local lookup, it's a pthread_getspecific on some platforms
+  auto& current = currentScope();
+  prev_ = current;
   auto currentEngine = prev_ != nullptr ? prev_->engine_ : nullptr;
+  // nested scope of the same engine (the common case of callbacks) is already entered,
+  // only the thread local is updated.
   needEnter_ = needEnter && engine != nullptr && engine != currentEngine;
   if (needEnter_) {
     if (engine->isDestroying()) {
@@ -50,7 +62,7 @@ EngineScope::EngineScope(EngineScope::InternalEnterEngine, EngineImpl* engine, b
     engineScopeImpl_.emplace(*engine, currentEngine);
   }
 
-  currentScope() = this;
+  current = this;
 }
 
 EngineScope::~EngineScope() {
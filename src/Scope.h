@@ -124,6 +124,9 @@ class EngineScope final {
   // the current EngineScope in stack, it's a thread local
   static EngineScope* getCurrent();
 
+  // dynamic_cast, skipped when engine is the current one (re-entered from callbacks)
+  static EngineImpl* toEngineImpl(ScriptEngine* engine);
+
   static void ensureEngineScope(void* engine);
 
   friend class ScriptEngine;
@@ -0,0 +1,434 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SerializedValue.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include "Engine.h"
+#include "Exception.h"
+#include "Scope.h"
+#include "Value.h"
+
+namespace script {
+
+namespace {
+
+/**
+ * wire format: one tag byte per value, followed by
+ *   kInt32      zigzag varint
+ *   kDouble     8 bytes little endian
+ *   kString     varint length, utf8 bytes
+ *   kArray      varint count, values
+ *   kObject     varint count, (varint key length, utf8 key bytes, value) pairs
+ *   kByteBuffer varint index into SerializedValue::byteBuffers_
+ *   kReference  varint id of an Array or Object written before, ids count from 0 in the order
+ *               the Arrays and Objects are written
+ */
+enum class Tag : uint8_t {
+  kNull = 0,
+  kTrue,
+  kFalse,
+  kInt32,
+  kDouble,
+  kString,
+  kArray,
+  kObject,
+  kByteBuffer,
+  kReference,
+};
+
+// bounds the native stack, cycles are detected by back references
+constexpr size_t kMaxDepth = 1000;
+
+/**
+ * Array/Object -> back reference id.
+ * There is no portable native identity of a script object, so the lookup is done in script,
+ * by a Map in JavaScript or a table in Lua, otherwise by a linear scan.
+ */
+class IdentityMap {
+ public:
+  IdentityMap() {
+#if defined(SCRIPTX_LANG_JAVASCRIPT)
+    auto ctor = EngineScope::currentEngine()->get("Map");
+    if (ctor.isFunction()) {
+      auto map = Object::newObject(ctor);
+      map_ = map;
+      get_ = map.get("get");
+      set_ = map.get("set");
+    }
+#elif defined(SCRIPTX_LANG_LUA)
+    auto engine = EngineScope::currentEngine();
+    map_ = Object::newObject();
+    get_ = engine->get("rawget");
+    set_ = engine->get("rawset");
+#endif
+    scripted_ = get_.isFunction() && set_.isFunction();
+  }
+
+  // -1 for not found
+  int64_t find(const Local<Value>& object) const {
+    if (scripted_) {
+      StackFrameScope stack;
+#if defined(SCRIPTX_LANG_JAVASCRIPT)
+      auto id = get_.asFunction().call(map_, object);
+#else
+      auto id = get_.asFunction().call({}, map_, object);
+#endif
+      return id.isNumber() ? id.asNumber().toInt64() : -1;
+    }
+    for (size_t i = 0; i < objects_.size(); ++i) {
+      if (objects_[i] == object) return static_cast<int64_t>(i);
+    }
+    return -1;
+  }
+
+  // ids are added in order
+  void add(const Local<Value>& object, size_t id) {
+    if (scripted_) {
+      StackFrameScope stack;
+      auto number = Number::newNumber(static_cast<int64_t>(id));
+#if defined(SCRIPTX_LANG_JAVASCRIPT)
+      set_.asFunction().call(map_, object, number);
+#else
+      set_.asFunction().call({}, map_, object, number);
+#endif
+    } else {
+      objects_.push_back(object);
+    }
+  }
+
+ private:
+  bool scripted_ = false;
+  Local<Value> map_;
+  Local<Value> get_;
+  Local<Value> set_;
+  std::vector<Local<Value>> objects_;
+};
+
+}  // namespace
+
+class SerializedValueWriter {
+ public:
+  explicit SerializedValueWriter(SerializedValue& out) : out_(out) {}
+
+  void writeValue(const Local<Value>& value, size_t depth) {
+    if (depth > kMaxDepth) {
+      throw Exception("SerializedValue: value nests too deep");
+    }
+
+    auto kind = value.getKind();
+    if (kind == ValueKind::kArray || kind == ValueKind::kObject) {
+      // shared Arrays and Objects are written once, then referenced by id
+      auto id = identities_.find(value);
+      if (id >= 0) {
+        if (writing_[static_cast<size_t>(id)]) {
+          throw Exception("SerializedValue: can't serialize value with a cycle");
+        }
+        writeTag(Tag::kReference);
+        writeVarint(static_cast<uint64_t>(id));
+        return;
+      }
+      id = static_cast<int64_t>(writing_.size());
+      identities_.add(value, writing_.size());
+      writing_.push_back(true);
+      if (kind == ValueKind::kArray) {
+        writeArray(value.asArray(), depth);
+      } else {
+        writeObject(value.asObject(), depth);
+      }
+      writing_[static_cast<size_t>(id)] = false;
+      return;
+    }
+
+    switch (kind) {
+      case ValueKind::kNull:
+        writeTag(Tag::kNull);
+        break;
+      case ValueKind::kBoolean:
+        writeTag(value.asBoolean().value() ? Tag::kTrue : Tag::kFalse);
+        break;
+      case ValueKind::kNumber:
+        writeNumber(value.asNumber().toDouble());
+        break;
+      case ValueKind::kString:
+        writeTag(Tag::kString);
+        writeString(value.asString().toString());
+        break;
+      case ValueKind::kByteBuffer:
+        writeByteBuffer(value.asByteBuffer());
+        break;
+      case ValueKind::kFunction:
+        throw Exception("SerializedValue: can't serialize Function");
+      case ValueKind::kUnsupported:
+      default:
+        throw Exception("SerializedValue: can't serialize unsupported value " +
+                        value.describeUtf8());
+    }
+  }
+
+ private:
+  void writeTag(Tag tag) { out_.data_.push_back(static_cast<uint8_t>(tag)); }
+
+  void writeVarint(uint64_t value) {
+    while (value >= 0x80u) {
+      out_.data_.push_back(static_cast<uint8_t>(value | 0x80u));
+      value >>= 7u;
+    }
+    out_.data_.push_back(static_cast<uint8_t>(value));
+  }
+
+  void writeNumber(double value) {
+    if (value >= std::numeric_limits<int32_t>::min() &&
+        value <= std::numeric_limits<int32_t>::max() && std::trunc(value) == value &&
+        !(value == 0 && std::signbit(value))) {
+      auto i = static_cast<int32_t>(value);
+      writeTag(Tag::kInt32);
+      // zigzag
+      writeVarint((static_cast<uint32_t>(i) << 1u) ^ static_cast<uint32_t>(i >> 31));
+      return;
+    }
+
+    uint64_t bits;
+    static_assert(sizeof(bits) == sizeof(value));
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeTag(Tag::kDouble);
+    for (int i = 0; i < 8; ++i) {
+      out_.data_.push_back(static_cast<uint8_t>(bits >> (i * 8)));
+    }
+  }
+
+  void writeString(const std::string& str) {
+    writeVarint(str.size());
+    out_.data_.insert(out_.data_.end(), str.begin(), str.end());
+  }
+
+  void writeArray(const Local<Array>& array, size_t depth) {
+    StackFrameScope stack;
+    auto size = array.size();
+    auto elements = array.getRange(0, size);
+
+    writeTag(Tag::kArray);
+    writeVarint(size);
+    for (auto& e : elements) {
+      writeValue(e, depth + 1);
+    }
+  }
+
+  void writeObject(const Local<Object>& object, size_t depth) {
+    StackFrameScope stack;
+    auto keys = object.getKeys();
+
+#ifdef SCRIPTX_LANG_LUA
+    // lua has no array type, write a sequence table as array
+    if (keys.empty()) {
+      auto array = object.asValue().asArray();
+      if (array.size() > 0) {
+        writeArray(array, depth);
+        return;
+      }
+    }
+#endif
+
+    writeTag(Tag::kObject);
+    writeVarint(keys.size());
+    for (auto& key : keys) {
+      writeString(key.toString());
+      writeValue(object.get(key), depth + 1);
+    }
+  }
+
+  void writeByteBuffer(const Local<ByteBuffer>& buffer) {
+    buffer.sync();
+    auto size = buffer.byteLength();
+    std::shared_ptr<void> data(new uint8_t[size == 0 ? 1 : size],
+                               [](void* ptr) { delete[] static_cast<uint8_t*>(ptr); });
+    if (size > 0) {
+      std::memcpy(data.get(), buffer.getRawBytes(), size);
+    }
+
+    writeTag(Tag::kByteBuffer);
+    writeVarint(out_.byteBuffers_.size());
+    out_.byteBuffers_.push_back({std::move(data), size});
+  }
+
+  SerializedValue& out_;
+  IdentityMap identities_;
+  // by id, whether the Array or Object is being written, ie. on the current path
+  std::vector<bool> writing_;
+};
+
+class SerializedValueReader {
+ public:
+  // in a StackFrameScope enclosing all reads
+  explicit SerializedValueReader(const SerializedValue& in)
+      : in_(in),
+        pos_(in.data_.data()),
+        end_(in.data_.data() + in.data_.size()),
+        objects_(Array::newArray()) {}
+
+  Local<Value> readValue(size_t depth) {
+    if (depth > kMaxDepth) malformed();
+
+    switch (static_cast<Tag>(readByte())) {
+      case Tag::kNull:
+        return {};
+      case Tag::kTrue:
+        return Boolean::newBoolean(true);
+      case Tag::kFalse:
+        return Boolean::newBoolean(false);
+      case Tag::kInt32: {
+        auto zigzag = readVarint();
+        if (zigzag > std::numeric_limits<uint32_t>::max()) malformed();
+        auto u = static_cast<uint32_t>(zigzag);
+        return Number::newNumber(static_cast<int32_t>((u >> 1u) ^ (~(u & 1u) + 1u)));
+      }
+      case Tag::kDouble: {
+        ensure(8);
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i) {
+          bits |= static_cast<uint64_t>(pos_[i]) << (i * 8);
+        }
+        pos_ += 8;
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return Number::newNumber(value);
+      }
+      case Tag::kString:
+        return String::newString(readString());
+      case Tag::kArray:
+        return readArray(depth);
+      case Tag::kObject:
+        return readObject(depth);
+      case Tag::kByteBuffer: {
+        auto index = readVarint();
+        if (index >= in_.byteBuffers_.size()) malformed();
+        auto& buffer = in_.byteBuffers_[index];
+        return ByteBuffer::newByteBuffer(buffer.data, buffer.size);
+      }
+      case Tag::kReference: {
+        auto id = readVarint();
+        if (id >= objectCount_) malformed();
+        return objects_.get(static_cast<size_t>(id));
+      }
+      default:
+        malformed();
+    }
+  }
+
+  bool atEnd() const { return pos_ == end_; }
+
+  [[noreturn]] static void malformed() { throw Exception("malformed SerializedValue"); }
+
+ private:
+  Local<Value> readArray(size_t depth) {
+    auto count = readCount();
+
+    StackFrameScope stack;
+    auto array = Array::newArray(count);
+    addObject(array);
+    for (size_t i = 0; i < count; ++i) {
+      StackFrameScope element;
+      array.set(i, readValue(depth + 1));
+    }
+    return stack.returnValue(array);
+  }
+
+  Local<Value> readObject(size_t depth) {
+    auto count = readCount();
+
+    StackFrameScope stack;
+    auto object = Object::newObject();
+    addObject(object);
+    for (size_t i = 0; i < count; ++i) {
+      StackFrameScope property;
+      auto key = readString();
+      object.set(key, readValue(depth + 1));
+    }
+    return stack.returnValue(object);
+  }
+
+  // ids count in the order the Arrays and Objects are written
+  void addObject(const Local<Value>& object) { objects_.set(objectCount_++, object); }
+
+  uint8_t readByte() {
+    ensure(1);
+    return *pos_++;
+  }
+
+  uint64_t readVarint() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      auto byte = readByte();
+      value |= static_cast<uint64_t>(byte & 0x7fu) << shift;
+      if ((byte & 0x80u) == 0) return value;
+    }
+    malformed();
+  }
+
+  // every element takes at least one byte, which bounds a bogus count
+  size_t readCount() {
+    auto count = readVarint();
+    if (count > static_cast<uint64_t>(end_ - pos_)) malformed();
+    return static_cast<size_t>(count);
+  }
+
+  std::string_view readString() {
+    auto size = readVarint();
+    if (size > static_cast<uint64_t>(end_ - pos_)) malformed();
+    std::string_view str(reinterpret_cast<const char*>(pos_), static_cast<size_t>(size));
+    pos_ += size;
+    return str;
+  }
+
+  void ensure(size_t size) {
+    if (static_cast<size_t>(end_ - pos_) < size) malformed();
+  }
+
+  const SerializedValue& in_;
+  const uint8_t* pos_;
+  const uint8_t* end_;
+  // indexed by back reference id
+  Local<Array> objects_;
+  size_t objectCount_ = 0;
+};
+
+SerializedValue SerializedValue::serialize(const Local<Value>& value) {
+  StackFrameScope stack;
+  SerializedValue ret;
+  SerializedValueWriter writer(ret);
+  writer.writeValue(value, 0);
+  return ret;
+}
+
+Local<Value> SerializedValue::deserialize() const {
+  if (isEmpty()) {
+    throw Exception("deserialize an empty SerializedValue");
+  }
+
+  StackFrameScope stack;
+  SerializedValueReader reader(*this);
+  auto ret = reader.readValue(0);
+  if (!reader.atEnd()) {
+    SerializedValueReader::malformed();
+  }
+  return stack.returnValue(ret);
+}
+
+}  // namespace script
@@ -0,0 +1,102 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Reference.h"
+#include "foundation.h"
+#include "types.h"
+
+namespace script {
+
+/**
+ * A script value serialized to native memory, which is independent of any ScriptEngine.
+ * It can be passed to another thread and deserialized in another engine (even of another
+ * backend), which is much cheaper than JSON.stringify + JSON.parse in script.
+ *
+ * Supported value kinds: Null, Boolean, Number, String, Array, Object (own enumerable properties)
+ * and ByteBuffer. Function and Unsupported values throw on serialize.
+ * An Array or Object referenced more than once is written once and shared again after
+ * deserialize, a cycle throws on serialize.
+ *
+ * ByteBuffer:
+ * the content is copied once to native memory on serialize, and is NOT copied again on
+ * deserialize, the deserialized ByteBuffer uses the native memory as backing store
+ * (ByteBuffer::newByteBuffer(std::shared_ptr<void>, size)).
+ * So the ownership of the memory is transferred to the receiving engine.
+ * note: deserialize the same SerializedValue more than once makes the ByteBuffers shared.
+ *
+ * \code
+ * SerializedValue data;
+ * {
+ *   EngineScope scope(engineA);
+ *   data = SerializedValue::serialize(engineA->eval("({a: 1, b: [1, 2]})"));
+ * }
+ *
+ * // maybe on another thread
+ * {
+ *   EngineScope scope(engineB);
+ *   Local<Value> value = data.deserialize();
+ * }
+ * \endcode
+ */
+class SerializedValue {
+ public:
+  /**
+   * an empty SerializedValue, deserialize() of which throws.
+   */
+  SerializedValue() = default;
+
+  /**
+   * serialize value in current EngineScope.
+   * @throw Exception if value contains Function or Unsupported value, a cycle, or nests too
+   * deep.
+   */
+  static SerializedValue serialize(const Local<Value>& value);
+
+  /**
+   * create value from this SerializedValue in current EngineScope.
+   * @throw Exception if this SerializedValue is empty or malformed.
+   */
+  Local<Value> deserialize() const;
+
+  bool isEmpty() const { return data_.empty(); }
+
+  /**
+   * @return the encoded bytes, ByteBuffer contents are not included.
+   */
+  const std::vector<uint8_t>& data() const { return data_; }
+
+  size_t byteBufferCount() const { return byteBuffers_.size(); }
+
+ private:
+  struct NativeBuffer {
+    std::shared_ptr<void> data;
+    size_t size;
+  };
+
+  std::vector<uint8_t> data_;
+  std::vector<NativeBuffer> byteBuffers_;
+
+  friend class SerializedValueWriter;
+  friend class SerializedValueReader;
+};
+
+}  // namespace script
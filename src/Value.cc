@@ -0,0 +1,113 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ScriptX/ScriptX.h>
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace script {
+
+namespace {
+
+[[noreturn]] void throwMapError(const std::string& path) {
+#if defined(_WIN32)
+  auto error = "error " + std::to_string(GetLastError());
+#else
+  std::string error = std::strerror(errno);
+#endif
+  throw Exception("failed to map file " + path + ": " + error);
+}
+
+}  // namespace
+
+Local<ByteBuffer> ByteBuffer::newMappedFile(const std::string& path, MapMode mode) {
+  auto shared = mode == MapMode::kShared;
+  void* address = nullptr;
+  size_t size = 0;
+
+#if defined(_WIN32)
+  auto file = CreateFileA(path.c_str(), shared ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                          FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) throwMapError(path);
+
+  LARGE_INTEGER fileSize{};
+  if (!GetFileSizeEx(file, &fileSize)) {
+    CloseHandle(file);
+    throwMapError(path);
+  }
+  size = static_cast<size_t>(fileSize.QuadPart);
+  if (size == 0) {
+    CloseHandle(file);
+    return newByteBuffer(0);
+  }
+
+  auto mapping = CreateFileMappingA(file, nullptr, shared ? PAGE_READWRITE : PAGE_WRITECOPY, 0,
+                                    0, nullptr);
+  CloseHandle(file);
+  if (!mapping) throwMapError(path);
+
+  // the view keeps the mapping alive
+  address = MapViewOfFile(mapping, shared ? FILE_MAP_WRITE : FILE_MAP_COPY, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!address) throwMapError(path);
+
+  std::shared_ptr<void> buffer(address, [](void* ptr) { UnmapViewOfFile(ptr); });
+#else
+  auto fd = open(path.c_str(), (shared ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+  if (fd < 0) throwMapError(path);
+
+  struct stat fileStat {};
+  if (fstat(fd, &fileStat) != 0) {
+    close(fd);
+    throwMapError(path);
+  }
+  size = static_cast<size_t>(fileStat.st_size);
+  if (size == 0) {
+    close(fd);
+    return newByteBuffer(0);
+  }
+
+  address = mmap(nullptr, size, PROT_READ | PROT_WRITE, shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+  if (address == MAP_FAILED) {
+    auto error = errno;
+    close(fd);
+    errno = error;
+    throwMapError(path);
+  }
+  // the mapping keeps the file alive
+  close(fd);
+
+  std::shared_ptr<void> buffer(address, [size](void* ptr) { munmap(ptr, size); });
+#endif
+
+  return newByteBuffer(std::move(buffer), size);
+}
+
+}  // namespace script
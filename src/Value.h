@@ -251,6 +251,12 @@ class Array : public Value {
 
   static Local<Array> newArray(const std::initializer_list<Local<Value>>& elements);
 
+  /**
+   * create array from a contiguous range of elements, without an intermediate container.
+   * @param elements pointer to the first element, can be nullptr if size is 0.
+   */
+  static Local<Array> newArray(const Local<Value>* elements, size_t size);
+
   /**
    * typesafe variadic template helper method
    * @tparam T MUST BE local reference, ie: Local<Type>. or supported raw C++ type to convert.
@@ -321,6 +327,31 @@ class ByteBuffer : public Value {
    *
    */
   static Local<ByteBuffer> newByteBuffer(std::shared_ptr<void> nativeBuffer, size_t size);
+
+  /**
+   * there is no read-only mode: a script may write to any ByteBuffer, which would crash on a
+   * read-only mapping. Use kCopyOnWrite to leave the file untouched.
+   */
+  enum class MapMode {
+    /** writes are private to the buffer, and never reach the file */
+    kCopyOnWrite,
+    /** the file is opened for writing, and writes reach the file */
+    kShared
+  };
+
+  /**
+   * create a new ByteBuffer backed by a memory mapping of the whole file,
+   * with newByteBuffer(std::shared_ptr<void>, size). The file is unmapped after the script
+   * object and all native references (getRawBytesShared) are released.
+   * on failure, an Exception is thrown.
+   *
+   * note: pages are read on first access, so scanning a large file costs no read or copy.
+   * note: on backends that don't support shared ByteBuffer, the content is copied, and with
+   * kShared the script's writes reach the file on commit().
+   * note: changing the size of a mapped file is undefined behavior.
+   */
+  static Local<ByteBuffer> newMappedFile(const std::string& path,
+                                         MapMode mode = MapMode::kCopyOnWrite);
 };
 
 class Unsupported : public Value {};
@@ -27,8 +27,11 @@
 #include "../../Includes.h"
 #include "../../Native.h"
 #include "../../Native.hpp"
+#include "../../Promise.h"
+#include "../../Coroutine.h"
 #include "../../Reference.h"
 #include "../../Scope.h"
+#include "../../SerializedValue.h"
 #include "../../Utils.h"
 #include "../../Value.h"
 
@@ -39,6 +42,9 @@
 
 // utils
 #include "../../utils/MessageQueue.h"
+#include "../../utils/SamplingTracer.h"
+#include "../../utils/ScriptChannel.h"
+#include "../../utils/ScriptExecutor.h"
 #include "../../utils/ThreadPool.h"
 
 namespace script {
@@ -19,7 +19,9 @@
 #include <cassert>
 #include <cstring>
 #include <list>
+#include <type_traits>
 #include "../foundation.h"
+#include "../types.h"
 #include "MemoryPool.hpp"
 
 namespace script::internal {
@@ -58,15 +60,29 @@ class GlobalWeakBookkeeping {
  private:
   ListType bookkeeping_{};
   bool isClearing_ = false;
+  size_t globalCount_ = 0;
+  size_t weakCount_ = 0;
 
   // for unit-test only
   friend struct TestAccessor;
 
+  template <typename T>
+  struct IsWeak : std::false_type {};
+
+  template <typename T>
+  struct IsWeak<Weak<T>> : std::true_type {};
+
+  template <typename T>
+  size_t& counter() noexcept {
+    return IsWeak<T>::value ? weakCount_ : globalCount_;
+  }
+
   template <typename T>
   void add(const T* ref, HandleType& handle) noexcept {
     assert(isHandleEmpty(handle));
     bookkeeping_.push_front(Bookkeeping{ref});
     handle = bookkeeping_.begin();
+    ++counter<T>();
   }
 
   static bool isHandleEmpty(const HandleType& handle) {
@@ -102,6 +118,7 @@ class GlobalWeakBookkeeping {
     assert(!isHandleEmpty(handle));
     if (!isClearing_) {
       bookkeeping_.erase(handle);
+      --counter<T>();
     }
     handle = {};
   }
@@ -160,9 +177,21 @@ class GlobalWeakBookkeeping {
       b.perform();
     }
     bookkeeping_.clear();
+    globalCount_ = 0;
+    weakCount_ = 0;
     isClearing_ = false;
   }
 
+  /**
+   * @return number of live Global references
+   */
+  size_t globalCount() const noexcept { return globalCount_; }
+
+  /**
+   * @return number of live Weak references
+   */
+  size_t weakCount() const noexcept { return weakCount_; }
+
   /**
    * \code
    * struct Fetcher {
@@ -18,6 +18,7 @@
 #include "MessageQueue.h"
 #include <algorithm>
 #include <unordered_map>
+#include <vector>
 #include "ThreadLocal.h"
 
 namespace script::utils {
@@ -152,13 +153,15 @@ void MessageQueue::setSupervisor(const std::shared_ptr<MessageQueue::Supervisor>
 }
 
 void MessageQueue::shutdownNow(bool awaitTermination) {
+  std::deque<Message*> dropped;
   {
     std::lock_guard<std::mutex> lk(queueMutex_);
     shutdown_ = ShutdownType::kNow;
-    for (auto r : queue_) {
-      releaseMessage(r);
-    }
-    queue_.clear();
+    dropped.swap(queue_);
+  }
+  // cleanup outside the lock, it may post to or remove from this queue
+  for (auto r : dropped) {
+    releaseMessage(r);
   }
 
   // wake up postMessage
@@ -234,12 +237,15 @@ int32_t MessageQueue::postMessage(Message* msg, int64_t delayNanos) {
   {
     std::unique_lock<std::mutex> lk(queueMutex_);
     awaitNotFullLocked(lk);
-    if (shutdown_ == ShutdownType::kNow) {
-      releaseMessage(msg);
-      return 0;
+    if (shutdown_ != ShutdownType::kNow) {
+      auto pos = findInsertPositionLocked(msg->dueTime, msg->priority);
+      queue_.insert(pos, msg);
+      msg = nullptr;
     }
-    auto pos = findInsertPositionLocked(msg->dueTime, msg->priority);
-    queue_.insert(pos, msg);
+  }
+  if (msg) {
+    releaseMessage(msg);
+    return 0;
   }
   queueNotEmptyCondition_.notify_all();
 
@@ -273,27 +279,30 @@ std::deque<Message*>::const_iterator MessageQueue::findInsertPositionLocked(
 
 bool MessageQueue::removeMessageIf(
     const std::function<RemoveMessagePredReturnType(Message&)>& pred) {
-  bool removed = false;
+  std::vector<Message*> removed;
   {
     std::lock_guard<std::mutex> lk(queueMutex_);
     for (auto it = queue_.begin(); it != queue_.end();) {
       auto type = pred(**it);
       if (type == RemoveMessagePredReturnType::kRemoveAndContinue ||
           type == RemoveMessagePredReturnType::kRemove) {
-        auto msg = *it;
+        removed.push_back(*it);
         it = queue_.erase(it);
-        releaseMessage(msg);
-        removed = true;
         if (type == RemoveMessagePredReturnType::kRemove) break;
       } else {
         ++it;
       }
     }
   }
-  if (removed) {
-    queueNotFullCondition_.notify_all();
+  if (removed.empty()) {
+    return false;
   }
-  return removed;
+  // cleanup outside the lock, it may post to or remove from this queue
+  for (auto msg : removed) {
+    releaseMessage(msg);
+  }
+  queueNotFullCondition_.notify_all();
+  return true;
 }
 
 bool MessageQueue::hasDueMessageLocked() const { return !queue_.empty() && queue_.front()->due(); }
@@ -306,6 +315,21 @@ size_t MessageQueue::dueMessageCount() const {
   return firstNotDue - queue_.begin();
 }
 
+MessageQueue::Stats MessageQueue::stats() const {
+  std::lock_guard<std::mutex> lk(queueMutex_);
+  auto now = timestamp();
+  Stats stats;
+  stats.messageCount = queue_.size();
+  // queue is ordered by due time
+  auto firstNotDue = std::find_if_not(queue_.begin(), queue_.end(),
+                                      [now](const Message* msg) { return msg->due(now); });
+  stats.dueMessageCount = firstNotDue - queue_.begin();
+  if (stats.dueMessageCount > 0) {
+    stats.oldestDueMessageAge = now - queue_.front()->dueTime;
+  }
+  return stats;
+}
+
 bool MessageQueue::checkQuitLoopNowLocked(MessageQueue::LoopType loopType, size_t onceMessageCount,
                                           MessageQueue::LoopReturnType& returnType) {
   if (shutdown_ == ShutdownType::kNow) {
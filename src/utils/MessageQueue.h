@@ -122,7 +122,8 @@ class Message : public ArbitraryData {
    * inplaceObject function can't be called with this constructor.
    *
    * note: you can do nearly everything inside handlerProc (except awaitTermination),
-   * however in the cleanupProc, be careful, not to call post or removeMessage.
+   * cleanupProc is called without the queue locked, it may post or remove messages
+   * (posting fails after shutdownNow), but must not wait on the queue.
    */
   Message(MessageProc* handlerProc, MessageProc* cleanupProc);
 
@@ -338,6 +339,20 @@ class MessageQueue {
    */
   void setSupervisor(const std::shared_ptr<Supervisor>& supervisor);
 
+  struct Stats {
+    /** messages in queue, including delayed ones */
+    size_t messageCount = 0;
+    /** messages whose due time has come */
+    size_t dueMessageCount = 0;
+    /** how long the earliest due message has been waiting past its due time, 0 if none */
+    std::chrono::nanoseconds oldestDueMessageAge{0};
+  };
+
+  /**
+   * a consistent snapshot of the queue, for monitoring purpose.
+   */
+  Stats stats() const;
+
   /**
    * @param delay a std::chrono::duration type like milliseconds nanoseconds
    * @return messageId used to removeMessage, return 0 for failure (already shutdown)
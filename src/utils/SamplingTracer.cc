@@ -0,0 +1,295 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SamplingTracer.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include "ThreadLocal.h"
+
+namespace script::utils {
+
+namespace {
+
+struct ThreadCache {
+  uint64_t tracerId = 0;
+  void* state = nullptr;
+};
+
+SCRIPTX_THREAD_LOCAL(ThreadCache, threadCache_);
+
+std::atomic<uint64_t> nextTracerId{1};
+
+int64_t nowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// only the owner thread writes, so a plain load + store is enough
+inline void singleWriterAdd(std::atomic<uint64_t>& value, uint64_t delta) {
+  value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+struct SamplingTracer::Histogram {
+  std::string name;
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> totalNanos{0};
+  std::atomic<uint64_t> maxNanos{0};
+  std::atomic<uint64_t> buckets[kBucketCount] = {};
+  Histogram* next = nullptr;
+
+  explicit Histogram(const char* traceName) : name(traceName) {}
+
+  void record(uint64_t nanos) {
+    singleWriterAdd(buckets[bucketIndex(nanos)], 1);
+    singleWriterAdd(count, 1);
+    singleWriterAdd(totalNanos, nanos);
+    if (nanos > maxNanos.load(std::memory_order_relaxed)) {
+      maxNanos.store(nanos, std::memory_order_relaxed);
+    }
+  }
+};
+
+struct SamplingTracer::ThreadState {
+  struct Frame {
+    const char* traceName;
+    // -1 for not sampled
+    int64_t startNanos;
+  };
+
+  std::thread::id thread = std::this_thread::get_id();
+  // traces until next sample
+  uint32_t countdown = 1;
+  uint64_t random = std::hash<std::thread::id>{}(thread) | 1u;
+  std::vector<Frame> stack;
+
+  // owner thread only
+  std::unordered_map<const char*, Histogram*> index;
+  // pushed by owner thread, traversed by snapshot
+  std::atomic<Histogram*> histograms{nullptr};
+
+  ThreadState* next = nullptr;
+
+  ThreadState() { stack.reserve(64); }
+
+  bool sample(uint32_t interval) {
+    if (--countdown != 0) return false;
+    // a random gap in [1, 2 * interval - 1] instead of a fixed one,
+    // so that the samples don't alias with a periodic call pattern.
+    random ^= random << 13u;
+    random ^= random >> 7u;
+    random ^= random << 17u;
+    countdown = 1 + static_cast<uint32_t>(random % (2 * static_cast<uint64_t>(interval) - 1));
+    return true;
+  }
+
+  ~ThreadState() {
+    auto h = histograms.load(std::memory_order_relaxed);
+    while (h) {
+      auto next = h->next;
+      delete h;
+      h = next;
+    }
+  }
+
+  Histogram* histogram(const char* traceName) {
+    auto it = index.find(traceName);
+    if (it != index.end()) return it->second;
+
+    auto h = new Histogram(traceName);
+    h->next = histograms.load(std::memory_order_relaxed);
+    histograms.store(h, std::memory_order_release);
+    index.emplace(traceName, h);
+    return h;
+  }
+};
+
+SamplingTracer::SamplingTracer(uint32_t sampleInterval)
+    : id_(nextTracerId.fetch_add(1, std::memory_order_relaxed)),
+      sampleInterval_((std::max)(sampleInterval, 1u)) {}
+
+SamplingTracer::~SamplingTracer() {
+  auto t = threads_.load(std::memory_order_acquire);
+  while (t) {
+    auto next = t->next;
+    delete t;
+    t = next;
+  }
+}
+
+void SamplingTracer::setSampleInterval(uint32_t sampleInterval) {
+  sampleInterval_.store((std::max)(sampleInterval, 1u), std::memory_order_relaxed);
+}
+
+size_t SamplingTracer::bucketIndex(uint64_t nanos) {
+  if (nanos < kSubBucketCount) return static_cast<size_t>(nanos);
+
+  size_t msb = 0;
+  for (size_t step = 32; step > 0; step >>= 1u) {
+    if (nanos >> (msb + step)) msb += step;
+  }
+  auto sub = (nanos >> (msb - kSubBucketBits)) & (kSubBucketCount - 1);
+  return (msb - kSubBucketBits + 1) * kSubBucketCount + static_cast<size_t>(sub);
+}
+
+uint64_t SamplingTracer::bucketLowerBound(size_t index) {
+  if (index < kSubBucketCount) return index;
+  auto msb = index / kSubBucketCount + kSubBucketBits - 1;
+  auto sub = index % kSubBucketCount;
+  return static_cast<uint64_t>(kSubBucketCount + sub) << (msb - kSubBucketBits);
+}
+
+SamplingTracer::ThreadState* SamplingTracer::currentThreadState() const noexcept {
+  auto& cache = internal::getThreadLocal(threadCache_);
+  if (cache.tracerId == id_) {
+    return static_cast<ThreadState*>(cache.state);
+  }
+
+  // another tracer was used on this thread, look up the existing state
+  auto self = std::this_thread::get_id();
+  auto state = threads_.load(std::memory_order_acquire);
+  while (state && state->thread != self) {
+    state = state->next;
+  }
+
+  if (!state) {
+    try {
+      state = new ThreadState();
+    } catch (...) {
+      return nullptr;
+    }
+    auto head = threads_.load(std::memory_order_relaxed);
+    do {
+      state->next = head;
+    } while (!threads_.compare_exchange_weak(head, state, std::memory_order_release,
+                                             std::memory_order_relaxed));
+  }
+
+  cache.tracerId = id_;
+  cache.state = state;
+  return state;
+}
+
+void SamplingTracer::beginTrace(ScriptEngine*, const char* traceName) const noexcept {
+  auto state = currentThreadState();
+  if (!state) return;
+
+  auto sampled = state->sample(sampleInterval_.load(std::memory_order_relaxed));
+
+  try {
+    state->stack.push_back({traceName ? traceName : "", sampled ? nowNanos() : -1});
+  } catch (...) {
+    // out of memory, the matching endTrace pops an outer frame at worst
+  }
+}
+
+void SamplingTracer::endTrace(ScriptEngine*) const noexcept {
+  auto state = currentThreadState();
+  if (!state || state->stack.empty()) return;
+
+  auto frame = state->stack.back();
+  state->stack.pop_back();
+  if (frame.startNanos < 0) return;
+
+  auto elapsed = nowNanos() - frame.startNanos;
+  try {
+    auto nanos = static_cast<uint64_t>((std::max)(elapsed, int64_t{0}));
+    state->histogram(frame.traceName)->record(nanos);
+  } catch (...) {
+  }
+}
+
+std::vector<SamplingTracer::Stats> SamplingTracer::snapshot() const {
+  std::map<std::string, Stats> merged;
+
+  for (auto t = threads_.load(std::memory_order_acquire); t; t = t->next) {
+    for (auto h = t->histograms.load(std::memory_order_acquire); h; h = h->next) {
+      auto& stats = merged[h->name];
+      stats.traceName = h->name;
+      stats.count += h->count.load(std::memory_order_relaxed);
+      stats.totalNanos += h->totalNanos.load(std::memory_order_relaxed);
+      stats.maxNanos = (std::max)(stats.maxNanos, h->maxNanos.load(std::memory_order_relaxed));
+      for (size_t i = 0; i < kBucketCount; ++i) {
+        stats.buckets[i] += h->buckets[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::vector<Stats> ret;
+  ret.reserve(merged.size());
+  for (auto& entry : merged) {
+    ret.push_back(std::move(entry.second));
+  }
+  return ret;
+}
+
+uint64_t SamplingTracer::Stats::percentile(double p) const {
+  // count of buckets may differ from count a little when read concurrently
+  uint64_t total = 0;
+  for (auto b : buckets) total += b;
+  if (total == 0) return 0;
+
+  auto rank = static_cast<uint64_t>(std::clamp(p, 0.0, 1.0) * static_cast<double>(total - 1));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen > rank) {
+      // middle of the bucket, but never above the recorded max
+      auto lower = bucketLowerBound(i);
+      auto upper = i + 1 < buckets.size() ? bucketLowerBound(i + 1) : lower;
+      return (std::min)(lower + (upper - lower) / 2, (std::max)(maxNanos, lower));
+    }
+  }
+  return maxNanos;
+}
+
+std::string SamplingTracer::dump() const {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1);
+  auto us = [](uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; };
+
+  out << "traceName count mean(us) p50(us) p90(us) p99(us) max(us)\n";
+  for (auto& s : snapshot()) {
+    out << s.traceName << ' ' << s.count << ' ' << us(s.meanNanos()) << ' '
+        << us(s.percentile(0.5)) << ' ' << us(s.percentile(0.9)) << ' '
+        << us(s.percentile(0.99)) << ' ' << us(s.maxNanos) << '\n';
+  }
+  return out.str();
+}
+
+void SamplingTracer::reset() {
+  for (auto t = threads_.load(std::memory_order_acquire); t; t = t->next) {
+    for (auto h = t->histograms.load(std::memory_order_acquire); h; h = h->next) {
+      h->count.store(0, std::memory_order_relaxed);
+      h->totalNanos.store(0, std::memory_order_relaxed);
+      h->maxNanos.store(0, std::memory_order_relaxed);
+      for (auto& b : h->buckets) {
+        b.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+}  // namespace script::utils
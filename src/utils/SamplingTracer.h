@@ -0,0 +1,128 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Utils.h"
+
+namespace script::utils {
+
+/**
+ * A Tracer::Delegate collecting latency histograms of every traceName (bound function, property,
+ * eval, etc.), cheap enough to be left on in production.
+ *
+ * 1. only 1 in N traces (on average, per thread) are timed, the others only cost a counter
+ * decrement.
+ * 2. each thread records into its own histograms, no lock and no atomic read-modify-write.
+ * 3. histograms are log-linear (like HdrHistogram), 16 sub-buckets per power of 2, about 6%
+ * relative error.
+ *
+ * \code
+ * static SamplingTracer tracer(100);
+ * Tracer::setDelegate(&tracer);
+ *
+ * // later, from any thread
+ * for (auto& s : tracer.snapshot()) {
+ *   report(s.traceName, s.count, s.percentile(0.5), s.percentile(0.99));
+ * }
+ * \endcode
+ *
+ * note: the tracer must outlive all threads tracing into it (keep it static, or unset the
+ * delegate and make sure no trace is in flight before destroying it).
+ */
+class SamplingTracer : public Tracer::Delegate {
+ public:
+  static constexpr size_t kSubBucketBits = 4;
+  static constexpr size_t kSubBucketCount = 1u << kSubBucketBits;
+  static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+  struct Stats {
+    std::string traceName;
+    // sampled count
+    uint64_t count = 0;
+    uint64_t totalNanos = 0;
+    uint64_t maxNanos = 0;
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(kBucketCount, 0);
+
+    /**
+     * @param p in [0, 1]
+     * @return approximate latency in nanoseconds at the given percentile
+     */
+    uint64_t percentile(double p) const;
+
+    uint64_t meanNanos() const { return count == 0 ? 0 : totalNanos / count; }
+  };
+
+  /**
+   * @param sampleInterval time one in every sampleInterval traces, 1 to time all.
+   */
+  explicit SamplingTracer(uint32_t sampleInterval = 1);
+
+  ~SamplingTracer();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(SamplingTracer);
+
+  void setSampleInterval(uint32_t sampleInterval);
+
+  uint32_t sampleInterval() const { return sampleInterval_.load(std::memory_order_relaxed); }
+
+  /**
+   * merge histograms of all threads, grouped by traceName.
+   * can be called on any thread while tracing.
+   */
+  std::vector<Stats> snapshot() const;
+
+  /**
+   * export snapshot() as text, one line per traceName:
+   * traceName count mean p50 p90 p99 max (in microseconds)
+   */
+  std::string dump() const;
+
+  /**
+   * clear all histograms, traces recorded concurrently may be partially lost.
+   */
+  void reset();
+
+  static size_t bucketIndex(uint64_t nanos);
+
+  /**
+   * @return the smallest value falls into the bucket
+   */
+  static uint64_t bucketLowerBound(size_t index);
+
+ protected:
+  void beginTrace(ScriptEngine* engine, const char* traceName) const noexcept override;
+
+  void endTrace(ScriptEngine* engine) const noexcept override;
+
+ private:
+  struct Histogram;
+  struct ThreadState;
+
+  ThreadState* currentThreadState() const noexcept;
+
+  const uint64_t id_;
+  std::atomic<uint32_t> sampleInterval_;
+  // lock-free push only list, freed on destruction
+  mutable std::atomic<ThreadState*> threads_{nullptr};
+};
+
+}  // namespace script::utils
@@ -0,0 +1,251 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ScriptChannel.h"
+#include <ScriptX/ScriptX.h>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+namespace script::utils {
+
+namespace {
+
+constexpr size_t kCacheLine = 64;
+
+constexpr size_t alignUp(size_t size) { return (size + kCacheLine - 1) & ~(kCacheLine - 1); }
+
+}  // namespace
+
+/**
+ * producer and consumer indices live on different cache lines to avoid false sharing.
+ *
+ * The ring is the bounded queue described by Dmitry Vyukov: each slot has a sequence number,
+ * slot of position p is writable when sequence == p, and readable when sequence == p + 1.
+ */
+struct ScriptChannel::Header {
+  alignas(kCacheLine) std::atomic<uint64_t> tail{0};
+  alignas(kCacheLine) std::atomic<uint64_t> head{0};
+};
+
+std::shared_ptr<ScriptChannel> ScriptChannel::create(size_t recordSize, size_t capacity,
+                                                     Mode mode) {
+  if (recordSize == 0) {
+    throw std::invalid_argument("ScriptChannel: recordSize must be greater than 0");
+  }
+  if (capacity > (static_cast<size_t>(1) << 31u)) {
+    throw std::invalid_argument("ScriptChannel: capacity too large");
+  }
+
+  // at least 2 slots, the sequence of a single slot can't tell full from empty
+  size_t roundedCapacity = 2;
+  while (roundedCapacity < capacity) {
+    roundedCapacity <<= 1u;
+  }
+  auto fixedSize =
+      alignUp(sizeof(Header)) + alignUp(sizeof(std::atomic<uint64_t>) * roundedCapacity);
+  if (recordSize > (SIZE_MAX - fixedSize) / roundedCapacity) {
+    throw std::invalid_argument("ScriptChannel: recordSize * capacity too large");
+  }
+  return std::shared_ptr<ScriptChannel>(new ScriptChannel(recordSize, roundedCapacity, mode));
+}
+
+ScriptChannel::ScriptChannel(size_t recordSize, size_t capacity, Mode mode)
+    : recordSize_(recordSize), mask_(capacity - 1), mode_(mode) {
+  auto headerSize = alignUp(sizeof(Header));
+  auto sequencesSize = alignUp(sizeof(std::atomic<uint64_t>) * capacity);
+  auto total = headerSize + sequencesSize + recordSize * capacity;
+
+  auto block = static_cast<uint8_t*>(::operator new(total, std::align_val_t(kCacheLine)));
+  memory_ = std::shared_ptr<void>(
+      block, [](void* ptr) { ::operator delete(ptr, std::align_val_t(kCacheLine)); });
+
+  header_ = new (block) Header();
+  sequences_ = reinterpret_cast<std::atomic<uint64_t>*>(block + headerSize);
+  for (size_t i = 0; i < capacity; ++i) {
+    new (sequences_ + i) std::atomic<uint64_t>(i);
+  }
+  records_ = block + headerSize + sequencesSize;
+  std::memset(records_, 0, recordSize * capacity);
+}
+
+// atomics are trivially destructible, memory_ frees the block once the last ByteBuffer is gone.
+ScriptChannel::~ScriptChannel() = default;
+
+size_t ScriptChannel::size() const {
+  auto head = header_->head.load(std::memory_order_acquire);
+  auto tail = header_->tail.load(std::memory_order_acquire);
+  return tail > head ? static_cast<size_t>(tail - head) : 0;
+}
+
+void* ScriptChannel::tryBeginPush() {
+  auto pos = header_->tail.load(std::memory_order_relaxed);
+  while (true) {
+    auto sequence = sequences_[pos & mask_].load(std::memory_order_acquire);
+    auto diff = static_cast<int64_t>(sequence - pos);
+    if (diff == 0) {
+      if (mode_ == Mode::kSingleProducer) {
+        header_->tail.store(pos + 1, std::memory_order_relaxed);
+        return slotAt(pos & mask_);
+      }
+      // on failure pos is reloaded
+      if (header_->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        return slotAt(pos & mask_);
+      }
+    } else if (diff < 0) {
+      // full
+      return nullptr;
+    } else {
+      // another producer took this slot
+      pos = header_->tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool ScriptChannel::endPush(void* slot) {
+  auto index = slotIndex(slot);
+  if (index > mask_ || slotAt(index) != slot) return false;
+
+  // only the producer owning the slot touches its sequence until it's published.
+  // reserved: sequence is the position, which is behind tail.
+  // published: position + 1; free: position, but not behind tail.
+  auto& sequence = sequences_[index];
+  auto pos = sequence.load(std::memory_order_acquire);
+  if ((pos & mask_) != index || pos >= header_->tail.load(std::memory_order_acquire)) {
+    return false;
+  }
+  sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+const void* ScriptChannel::tryBeginPop() {
+  auto pos = header_->head.load(std::memory_order_relaxed);
+  auto sequence = sequences_[pos & mask_].load(std::memory_order_acquire);
+  if (sequence != pos + 1) {
+    return nullptr;
+  }
+  return slotAt(pos & mask_);
+}
+
+bool ScriptChannel::endPop() {
+  auto pos = header_->head.load(std::memory_order_relaxed);
+  auto& sequence = sequences_[pos & mask_];
+  if (sequence.load(std::memory_order_acquire) != pos + 1) {
+    // nothing published at head
+    return false;
+  }
+  sequence.store(pos + mask_ + 1, std::memory_order_release);
+  header_->head.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool ScriptChannel::tryPush(const void* record) {
+  auto slot = tryBeginPush();
+  if (!slot) return false;
+  std::memcpy(slot, record, recordSize_);
+  endPush(slot);
+  return true;
+}
+
+bool ScriptChannel::tryPop(void* record) {
+  auto slot = tryBeginPop();
+  if (!slot) return false;
+  std::memcpy(record, slot, recordSize_);
+  endPop();
+  return true;
+}
+
+size_t ScriptChannel::slotIndex(const void* slot) const {
+  // a pointer before records_ wraps to a huge index
+  return static_cast<size_t>(static_cast<const uint8_t*>(slot) - records_) / recordSize_;
+}
+
+std::shared_ptr<void> ScriptChannel::storage() const {
+  // aliasing constructor, shares ownership of the whole block
+  return std::shared_ptr<void>(memory_, records_);
+}
+
+Local<Object> ScriptChannel::newScriptObject() {
+  auto self = shared_from_this();
+
+  auto checkRecord = [self](const Local<Value>& bytes) {
+    auto buffer = bytes.asByteBuffer();
+    if (buffer.byteLength() < self->recordSize_) {
+      throw Exception("ScriptChannel: ByteBuffer is smaller than recordSize");
+    }
+    return buffer;
+  };
+
+  // slots reserved by beginPush of this object, only they can be ended by endPush
+  auto reserved = std::make_shared<std::vector<bool>>(capacity(), false);
+
+  auto obj = Object::newObject();
+  obj.set("recordSize", static_cast<int64_t>(recordSize_));
+  obj.set("capacity", static_cast<int64_t>(capacity()));
+  obj.set("buffer", ByteBuffer::newByteBuffer(storage(), capacity() * recordSize_));
+
+  obj.set("size", Function::newFunction([self]() { return static_cast<int64_t>(self->size()); }));
+
+  obj.set("push", Function::newFunction([self, checkRecord](const Local<Value>& bytes) {
+            auto buffer = checkRecord(bytes);
+            buffer.sync();
+            return self->tryPush(buffer.getRawBytes());
+          }));
+
+  obj.set("pop", Function::newFunction([self, checkRecord](const Local<Value>& bytes) {
+            auto buffer = checkRecord(bytes);
+            // the ByteBuffer may be larger than a record, keep the rest of it
+            buffer.sync();
+            if (!self->tryPop(buffer.getRawBytes())) return false;
+            buffer.commit();
+            return true;
+          }));
+
+  obj.set("beginPush", Function::newFunction([self, reserved]() -> int64_t {
+            auto slot = self->tryBeginPush();
+            if (!slot) return -1;
+            auto index = self->slotIndex(slot);
+            (*reserved)[index] = true;
+            return static_cast<int64_t>(index);
+          }));
+
+  obj.set("endPush", Function::newFunction([self, reserved](int64_t slot) {
+            if (slot < 0 || static_cast<uint64_t>(slot) > self->mask_ ||
+                !(*reserved)[static_cast<size_t>(slot)]) {
+              throw Exception("ScriptChannel: slot is not reserved by beginPush");
+            }
+            (*reserved)[static_cast<size_t>(slot)] = false;
+            self->endPush(self->slotAt(static_cast<size_t>(slot)));
+          }));
+
+  obj.set("beginPop", Function::newFunction([self]() -> int64_t {
+            auto slot = self->tryBeginPop();
+            return slot ? static_cast<int64_t>(self->slotIndex(slot)) : -1;
+          }));
+
+  obj.set("endPop", Function::newFunction([self]() {
+            if (!self->endPop()) {
+              throw Exception("ScriptChannel: no record to pop");
+            }
+          }));
+
+  return obj;
+}
+
+}  // namespace script::utils
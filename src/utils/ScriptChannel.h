@@ -0,0 +1,165 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "../Reference.h"
+#include "../foundation.h"
+
+namespace script::utils {
+
+/**
+ * A lock-free bounded ring buffer of fixed-size records in native memory, used to stream data
+ * between engines (and native code) on different threads without going through MessageQueue.
+ *
+ * There is always ONE consumer (thread) at a time, and either one producer (Mode::kSingleProducer)
+ * or any number of producers (Mode::kMultiProducer).
+ *
+ * The record storage can be exposed to any engine as a ByteBuffer sharing the same memory
+ * (ByteBuffer::newByteBuffer(std::shared_ptr<void>, size)), together with the push/pop functions,
+ * see newScriptObject().
+ *
+ * \code
+ * auto channel = ScriptChannel::create(sizeof(Event), 1024, ScriptChannel::Mode::kMultiProducer);
+ *
+ * // producer threads
+ * channel->tryPush(&event);
+ *
+ * // consumer engine thread
+ * EngineScope scope(engine);
+ * engine->set("events", channel->newScriptObject());
+ * \endcode
+ */
+class ScriptChannel : public std::enable_shared_from_this<ScriptChannel> {
+ public:
+  enum class Mode { kSingleProducer, kMultiProducer };
+
+  /**
+   * @param recordSize size of each record in bytes, must be greater than 0.
+   * @param capacity max record count, rounded up to power of 2.
+   * @throw std::invalid_argument
+   */
+  static std::shared_ptr<ScriptChannel> create(size_t recordSize, size_t capacity,
+                                               Mode mode = Mode::kSingleProducer);
+
+  ~ScriptChannel();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(ScriptChannel);
+
+  size_t recordSize() const { return recordSize_; }
+
+  size_t capacity() const { return mask_ + 1; }
+
+  Mode mode() const { return mode_; }
+
+  /**
+   * @return record count in the channel, approximate when called concurrently.
+   */
+  size_t size() const;
+
+  /**
+   * copy recordSize() bytes from record into the channel.
+   * @return false if the channel is full.
+   */
+  bool tryPush(const void* record);
+
+  /**
+   * copy the oldest record into record, which must have room for recordSize() bytes.
+   * @return false if the channel is empty.
+   */
+  bool tryPop(void* record);
+
+  /**
+   * Zero copy write: reserve a slot to write the record in place.
+   * @return the slot, or nullptr if the channel is full. endPush(slot) must be called when done.
+   * note: in kMultiProducer mode, a reserved but not yet ended slot blocks the consumer
+   * from reading records after it.
+   */
+  void* tryBeginPush();
+
+  /**
+   * publish a slot reserved by tryBeginPush.
+   * @return false (and nothing is changed) if the slot is not reserved, ie. ended twice.
+   */
+  bool endPush(void* slot);
+
+  /**
+   * Zero copy read: peek the oldest record in place.
+   * @return the slot, or nullptr if the channel is empty. endPop() must be called when done.
+   */
+  const void* tryBeginPop();
+
+  /**
+   * release the record returned by tryBeginPop.
+   * @return false (and nothing is changed) if there is no readable record.
+   */
+  bool endPop();
+
+  /**
+   * @return slot index of given slot pointer, slot i is at offset i * recordSize() of the storage.
+   */
+  size_t slotIndex(const void* slot) const;
+
+  /**
+   * the whole record storage, capacity() * recordSize() bytes. shared by all engines.
+   */
+  std::shared_ptr<void> storage() const;
+
+  /**
+   * create a script object in current EngineScope:
+   *
+   * \code
+   * channel.recordSize          // number
+   * channel.capacity            // number
+   * channel.buffer              // ByteBuffer of storage()
+   * channel.size()              // number
+   * channel.push(bytes)         // copy a record from ByteBuffer, false if full
+   * channel.pop(bytes)          // copy a record into ByteBuffer, false if empty
+   * channel.beginPush()         // zero copy, slot index to write in buffer, -1 if full
+   * channel.endPush(slot)      // throws if slot is not reserved by beginPush of this object
+   * channel.beginPop()          // zero copy, slot index to read in buffer, -1 if empty
+   * channel.endPop()            // throws if there is no record to pop
+   * \endcode
+   *
+   * note: the zero copy functions require the ByteBuffer to be shared (see
+   * Local<ByteBuffer>::isShared()), otherwise use push/pop, which sync and commit the ByteBuffer.
+   * note: the script object holds a reference to the channel.
+   */
+  Local<Object> newScriptObject();
+
+ private:
+  struct Header;
+
+  ScriptChannel(size_t recordSize, size_t capacity, Mode mode);
+
+  uint8_t* slotAt(size_t index) const { return records_ + index * recordSize_; }
+
+  const size_t recordSize_;
+  const size_t mask_;
+  const Mode mode_;
+
+  // header, sequence numbers and records are allocated in one block
+  std::shared_ptr<void> memory_;
+  Header* header_;
+  std::atomic<uint64_t>* sequences_;
+  uint8_t* records_;
+};
+
+}  // namespace script::utils
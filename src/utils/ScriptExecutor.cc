@@ -0,0 +1,275 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ScriptExecutor.h"
+#include <ScriptX/ScriptX.h>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace script::utils {
+
+struct ScriptExecutor::Worker {
+  std::shared_ptr<MessageQueue> queue;
+  std::unique_ptr<std::thread> thread;
+  ScriptEngine* engine = nullptr;
+  size_t index = 0;
+
+  // posted but not yet finished (handled or removed)
+  std::atomic_size_t pending{0};
+
+  // engine creation handshake
+  std::mutex startMutex;
+  std::condition_variable startCondition;
+  bool started = false;
+  std::exception_ptr startError;
+};
+
+namespace {
+
+// splitmix64 finalizer, spread the ring nodes and user provided hashes evenly.
+uint64_t mixHash(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27u)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31u);
+}
+
+void pinCurrentThread(size_t index) {
+  auto cpuCount = std::thread::hardware_concurrency();
+  if (cpuCount == 0) return;
+  auto cpu = index % cpuCount;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  // failure is not fatal, the thread just runs unpinned
+  sched_setaffinity(0, sizeof(set), &set);
+#elif defined(_WIN32)
+  SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu);
+#else
+  SCRIPTX_UNUSED(cpu);
+#endif
+}
+
+void runTask(Message& msg) {
+  auto task = static_cast<ScriptExecutor::Task*>(msg.ptr0);
+  auto engine = static_cast<ScriptEngine*>(msg.ptr2);
+  try {
+    EngineScope scope(engine);
+    (*task)(*engine);
+  } catch (const Exception& e) {
+    Logger() << "uncaught exception in ScriptExecutor task: " << e;
+  } catch (const std::exception& e) {
+    Logger() << "uncaught exception in ScriptExecutor task: " << e.what();
+  }
+}
+
+}  // namespace
+
+ScriptExecutor::ScriptExecutor(EngineFactory factory) : ScriptExecutor(std::move(factory), {}) {}
+
+ScriptExecutor::ScriptExecutor(EngineFactory factory, const Options& options)
+    : workers_(), hashRing_(), maxMessageInQueue_(options.maxMessageInQueue) {
+  auto count = options.engineCount;
+  if (count == 0) {
+    count = (std::max)(std::thread::hardware_concurrency(), 1u);
+  }
+
+  workers_.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto worker = std::make_unique<Worker>();
+    worker->index = i;
+    worker->queue = std::make_shared<MessageQueue>(options.maxMessageInQueue);
+    workers_.push_back(std::move(worker));
+  }
+
+  for (auto& w : workers_) {
+    w->thread = std::make_unique<std::thread>(runWorker, w.get(), &factory, options.pinThreads);
+  }
+
+  // the factory is referenced by worker threads until started
+  std::exception_ptr error;
+  for (auto& w : workers_) {
+    std::unique_lock<std::mutex> lk(w->startMutex);
+    w->startCondition.wait(lk, [&w] { return w->started; });
+    if (w->startError && !error) {
+      error = w->startError;
+    }
+  }
+
+  if (error) {
+    shutdown(false);
+    std::rethrow_exception(error);
+  }
+
+  buildHashRing(options.virtualNodesPerEngine);
+}
+
+ScriptExecutor::~ScriptExecutor() { shutdown(true); }
+
+void ScriptExecutor::runWorker(Worker* worker, const EngineFactory* factory, bool pinThread) {
+  if (pinThread) {
+    pinCurrentThread(worker->index);
+  }
+
+  UniqueEnginePtr engine;
+  {
+    std::lock_guard<std::mutex> lk(worker->startMutex);
+    try {
+      engine.reset((*factory)(worker->queue));
+      if (!engine) {
+        throw std::logic_error("ScriptExecutor: EngineFactory returns nullptr");
+      }
+      worker->engine = engine.get();
+    } catch (...) {
+      worker->startError = std::current_exception();
+    }
+    worker->started = true;
+  }
+  worker->startCondition.notify_all();
+
+  if (!engine) return;
+
+  while (worker->queue->loopQueue() != MessageQueue::LoopReturnType::kShutDown) {
+  }
+
+  // destroy engine on its own thread
+  engine.reset();
+}
+
+void ScriptExecutor::buildHashRing(size_t virtualNodesPerEngine) {
+  virtualNodesPerEngine = (std::max)(virtualNodesPerEngine, static_cast<size_t>(1));
+  hashRing_.reserve(workers_.size() * virtualNodesPerEngine);
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    for (size_t v = 0; v < virtualNodesPerEngine; ++v) {
+      hashRing_.emplace_back(mixHash((static_cast<uint64_t>(i) << 32u) | v), i);
+    }
+  }
+  std::sort(hashRing_.begin(), hashRing_.end());
+}
+
+ScriptEngine* ScriptExecutor::engine(size_t engineIndex) const {
+  return workers_.at(engineIndex)->engine;
+}
+
+std::shared_ptr<MessageQueue> ScriptExecutor::messageQueue(size_t engineIndex) const {
+  return workers_.at(engineIndex)->queue;
+}
+
+size_t ScriptExecutor::pendingTaskCount(size_t engineIndex) const {
+  return workers_.at(engineIndex)->pending.load(std::memory_order_relaxed);
+}
+
+size_t ScriptExecutor::engineIndexForKey(uint64_t keyHash) const {
+  auto hash = mixHash(keyHash);
+  auto it = std::lower_bound(hashRing_.begin(), hashRing_.end(),
+                             std::pair<uint64_t, size_t>{hash, 0});
+  if (it == hashRing_.end()) {
+    it = hashRing_.begin();
+  }
+  return it->second;
+}
+
+size_t ScriptExecutor::leastLoadedEngineIndex() const {
+  // start from a rotating offset, so that ties are spread across engines
+  auto count = workers_.size();
+  auto start = roundRobin_.fetch_add(1, std::memory_order_relaxed) % count;
+  auto best = start;
+  auto bestLoad = workers_[start]->pending.load(std::memory_order_relaxed);
+
+  for (size_t i = 1; i < count && bestLoad != 0; ++i) {
+    auto index = (start + i) % count;
+    auto load = workers_[index]->pending.load(std::memory_order_relaxed);
+    if (load < bestLoad) {
+      best = index;
+      bestLoad = load;
+    }
+  }
+  return best;
+}
+
+int32_t ScriptExecutor::post(size_t engineIndex, Task task) {
+  auto& worker = *workers_.at(engineIndex);
+  if (isShutdown_.load(std::memory_order_acquire)) {
+    return 0;
+  }
+  return postToWorker(worker, std::move(task));
+}
+
+int32_t ScriptExecutor::tryPost(size_t engineIndex, Task task) {
+  auto& worker = *workers_.at(engineIndex);
+  if (isShutdown_.load(std::memory_order_acquire)) {
+    return 0;
+  }
+  // approximate check, concurrent producers may still over-commit the queue a little,
+  // in which case post blocks until there is room.
+  if (worker.pending.load(std::memory_order_relaxed) >= maxMessageInQueue_) {
+    return 0;
+  }
+  return postToWorker(worker, std::move(task));
+}
+
+int32_t ScriptExecutor::postToWorker(Worker& worker, Task task) {
+  Message msg(runTask, [](Message& msg) {
+    delete static_cast<Task*>(msg.ptr0);
+    static_cast<Worker*>(msg.ptr1)->pending.fetch_sub(1, std::memory_order_relaxed);
+  });
+  msg.ptr0 = new Task(std::move(task));
+  msg.ptr1 = &worker;
+  msg.ptr2 = worker.engine;
+  msg.tag = worker.engine;
+  msg.name = "ScriptExecutor::Task";
+
+  worker.pending.fetch_add(1, std::memory_order_relaxed);
+  // on failure the message is cleaned up by the queue
+  return worker.queue->postMessage(msg);
+}
+
+void ScriptExecutor::shutdown(bool awaitQueue) {
+  if (isShutdown_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  for (auto& w : workers_) {
+    if (awaitQueue) {
+      w->queue->shutdown(false);
+    } else {
+      w->queue->shutdownNow(false);
+    }
+  }
+
+  for (auto& w : workers_) {
+    if (w->thread && w->thread->joinable()) {
+      w->thread->join();
+    }
+    // drop tasks posted concurrently with shutdown after the worker quit, and wake up blocked
+    // posts, they fail from now on.
+    w->queue->shutdownNow(false);
+  }
+}
+
+}  // namespace script::utils
@@ -0,0 +1,177 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../Engine.h"
+#include "MessageQueue.h"
+
+namespace script::utils {
+
+/**
+ * Run N ScriptEngines in parallel, each engine lives on its own (optionally cpu pinned) thread
+ * and owns a dedicated MessageQueue.
+ *
+ * Tasks are routed to engines by index, by key (consistent hashing, same key always goes to the
+ * same engine) or to the least loaded engine.
+ *
+ * Back pressure: each queue is created with Options::maxMessageInQueue, post() blocks when the
+ * target queue is full, while tryPost() returns 0 instead.
+ *
+ * \code
+ * ScriptExecutor executor(
+ *     [](const std::shared_ptr<MessageQueue>& queue) { return new ScriptEngineImpl(queue); });
+ *
+ * executor.postByKey("user:42", [](ScriptEngine& engine) {
+ *   // EngineScope is already entered
+ *   engine.eval("handle(42)");
+ * });
+ * \endcode
+ */
+class ScriptExecutor {
+ public:
+  /**
+   * create an engine bound to the given queue. called on the worker thread that owns the engine.
+   */
+  using EngineFactory = std::function<ScriptEngine*(const std::shared_ptr<MessageQueue>& queue)>;
+
+  /**
+   * a task runs on the engine thread, with EngineScope of engine entered.
+   */
+  using Task = std::function<void(ScriptEngine& engine)>;
+
+  struct Options {
+    /**
+     * how many engines(threads) to run, 0 for std::thread::hardware_concurrency().
+     */
+    size_t engineCount = 0;
+
+    /**
+     * capacity of each engine's MessageQueue, post() blocks when the queue is full.
+     */
+    size_t maxMessageInQueue = MessageQueue::kDefaultMaxMessageInQueue;
+
+    /**
+     * pin engine thread i to cpu (i % hardware_concurrency).
+     * only supported on Linux, Android and Windows, ignored elsewhere.
+     */
+    bool pinThreads = false;
+
+    /**
+     * virtual nodes per engine on the consistent hashing ring.
+     */
+    size_t virtualNodesPerEngine = 64;
+  };
+
+  /**
+   * start all engine threads, and wait for all engines to be created.
+   * @throw rethrow the exception thrown by factory, if any.
+   */
+  explicit ScriptExecutor(EngineFactory factory);
+
+  ScriptExecutor(EngineFactory factory, const Options& options);
+
+  /**
+   * shutdown(true)
+   */
+  ~ScriptExecutor();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(ScriptExecutor);
+
+  size_t engineCount() const { return workers_.size(); }
+
+  /**
+   * note: the engine can only be used on its own thread, ie. inside a Task.
+   */
+  ScriptEngine* engine(size_t engineIndex) const;
+
+  std::shared_ptr<MessageQueue> messageQueue(size_t engineIndex) const;
+
+  /**
+   * @return count of posted tasks that are not finished yet.
+   */
+  size_t pendingTaskCount(size_t engineIndex) const;
+
+  /**
+   * @return the engine a key is routed to.
+   */
+  size_t engineIndexForKey(uint64_t keyHash) const;
+
+  size_t engineIndexForKey(std::string_view key) const {
+    return engineIndexForKey(static_cast<uint64_t>(std::hash<std::string_view>{}(key)));
+  }
+
+  /**
+   * @return the engine with fewest pending tasks.
+   */
+  size_t leastLoadedEngineIndex() const;
+
+  /**
+   * post task to the given engine, block if the queue is full.
+   * @return messageId, 0 for failure (already shutdown)
+   */
+  int32_t post(size_t engineIndex, Task task);
+
+  /**
+   * post task to the given engine, return 0 immediately if the queue is full.
+   * @return messageId, 0 for failure (queue full or already shutdown)
+   */
+  int32_t tryPost(size_t engineIndex, Task task);
+
+  int32_t postByKey(uint64_t keyHash, Task task) {
+    return post(engineIndexForKey(keyHash), std::move(task));
+  }
+
+  int32_t postByKey(std::string_view key, Task task) {
+    return post(engineIndexForKey(key), std::move(task));
+  }
+
+  int32_t postToLeastLoaded(Task task) { return post(leastLoadedEngineIndex(), std::move(task)); }
+
+  /**
+   * shutdown all engine threads, engines are destroyed on their own thread.
+   * Once called, post and tryPost return 0.
+   * @param awaitQueue true to run all queued tasks before quit, otherwise they are dropped.
+   */
+  void shutdown(bool awaitQueue = true);
+
+ private:
+  struct Worker;
+
+  void buildHashRing(size_t virtualNodesPerEngine);
+
+  int32_t postToWorker(Worker& worker, Task task);
+
+  static void runWorker(Worker* worker, const EngineFactory* factory, bool pinThread);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  // sorted by hash
+  std::vector<std::pair<uint64_t, size_t>> hashRing_;
+  mutable std::atomic_size_t roundRobin_{0};
+  size_t maxMessageInQueue_;
+  // set once shutdown starts, posts fail from then on
+  std::atomic_bool isShutdown_{false};
+};
+
+}  // namespace script::utils
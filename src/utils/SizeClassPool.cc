@@ -0,0 +1,109 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SizeClassPool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace script::utils {
+
+SizeClassPool::~SizeClassPool() {
+  for (auto slab : slabs_) {
+    std::free(slab);
+  }
+}
+
+void* SizeClassPool::allocateSmall(size_t sizeClass) noexcept {
+  auto& sc = sizeClasses_[sizeClass];
+  if (sc.freeList) {
+    auto block = sc.freeList;
+    sc.freeList = block->next;
+    return block;
+  }
+
+  auto blockSize = (sizeClass + 1) * kAlignment;
+  if (sc.bumpBegin == nullptr || static_cast<size_t>(sc.bumpEnd - sc.bumpBegin) < blockSize) {
+    try {
+      slabs_.reserve(slabs_.size() + 1);
+    } catch (...) {
+      return nullptr;
+    }
+    // malloc is aligned for any fundamental type, so are the blocks (multiple of kAlignment)
+    auto slab = std::malloc(kSlabSize);
+    if (!slab) return nullptr;
+    slabs_.push_back(slab);
+    // the tail of the previous slab (less than a block) is wasted
+    sc.bumpBegin = static_cast<char*>(slab);
+    sc.bumpEnd = sc.bumpBegin + kSlabSize;
+  }
+
+  auto block = sc.bumpBegin;
+  sc.bumpBegin += blockSize;
+  return block;
+}
+
+void* SizeClassPool::allocate(size_t size) noexcept {
+  if (size == 0) return nullptr;
+  if (size <= kMaxSmallSize) {
+    return allocateSmall(sizeClassOf(size));
+  }
+  auto ret = std::malloc(size);
+  if (ret) largeBytes_ += size;
+  return ret;
+}
+
+void SizeClassPool::deallocate(void* ptr, size_t size) noexcept {
+  if (!ptr) return;
+  if (size <= kMaxSmallSize) {
+    auto& sc = sizeClasses_[sizeClassOf(size)];
+    auto block = static_cast<FreeBlock*>(ptr);
+    block->next = sc.freeList;
+    sc.freeList = block;
+  } else {
+    largeBytes_ -= size;
+    std::free(ptr);
+  }
+}
+
+void* SizeClassPool::reallocate(void* ptr, size_t oldSize, size_t newSize) noexcept {
+  if (!ptr) return allocate(newSize);
+  if (newSize == 0) {
+    deallocate(ptr, oldSize);
+    return nullptr;
+  }
+
+  auto oldSmall = oldSize <= kMaxSmallSize;
+  auto newSmall = newSize <= kMaxSmallSize;
+  if (oldSmall && newSmall && sizeClassOf(oldSize) == sizeClassOf(newSize)) {
+    return ptr;
+  }
+  if (!oldSmall && !newSmall) {
+    auto ret = std::realloc(ptr, newSize);
+    if (ret) largeBytes_ = largeBytes_ - oldSize + newSize;
+    return ret;
+  }
+
+  auto ret = allocate(newSize);
+  if (ret) {
+    std::memcpy(ret, ptr, (std::min)(oldSize, newSize));
+    deallocate(ptr, oldSize);
+  }
+  return ret;
+}
+
+}  // namespace script::utils
@@ -0,0 +1,96 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "../foundation.h"
+
+namespace script::utils {
+
+/**
+ * A single threaded allocator for small blocks, to be owned by one engine.
+ *
+ * 1. blocks up to kMaxSmallSize are rounded up to a multiple of kAlignment (a size class),
+ * and carved from kSlabSize slabs, freed blocks go to the free list of its size class.
+ * 2. larger blocks go to malloc.
+ * 3. the caller passes the block size back on deallocate, so blocks carry no header.
+ * 4. slabs are only returned to the system when the pool is destroyed.
+ *
+ * Small blocks are served without touching the global malloc, so engines on different threads
+ * don't contend with each other.
+ */
+class SizeClassPool {
+ public:
+  static constexpr size_t kAlignment = 16;
+  static constexpr size_t kMaxSmallSize = 256;
+  static constexpr size_t kSizeClassCount = kMaxSmallSize / kAlignment;
+  static constexpr size_t kSlabSize = 16 * 1024;
+
+  SizeClassPool() = default;
+
+  /**
+   * release all slabs, blocks from malloc must be deallocated by the caller before.
+   */
+  ~SizeClassPool();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(SizeClassPool);
+
+  /**
+   * @return nullptr on failure or size == 0
+   */
+  void* allocate(size_t size) noexcept;
+
+  /**
+   * @param size must be the size the block is allocated (or reallocated) with.
+   */
+  void deallocate(void* ptr, size_t size) noexcept;
+
+  /**
+   * realloc semantic, with the old size given.
+   * @return nullptr on failure (the old block is kept) or newSize == 0 (the old block is freed)
+   */
+  void* reallocate(void* ptr, size_t oldSize, size_t newSize) noexcept;
+
+  /**
+   * @return bytes held from the system, slabs plus large blocks.
+   */
+  size_t reservedBytes() const { return slabs_.size() * kSlabSize + largeBytes_; }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct SizeClass {
+    FreeBlock* freeList = nullptr;
+    // the unused tail of the latest slab
+    char* bumpBegin = nullptr;
+    char* bumpEnd = nullptr;
+  };
+
+  static size_t sizeClassOf(size_t size) { return (size + kAlignment - 1) / kAlignment - 1; }
+
+  void* allocateSmall(size_t sizeClass) noexcept;
+
+  SizeClass sizeClasses_[kSizeClassCount];
+  std::vector<void*> slabs_;
+  size_t largeBytes_ = 0;
+};
+
+}  // namespace script::utils
@@ -0,0 +1,82 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <thread>
+#include "../foundation.h"
+
+namespace script::utils {
+
+/**
+ * The thread an engine is bound to, see ScriptEngine::ThreadMode::kSingleThread.
+ * An unbound affinity allows any thread (guarded by the engine's lock).
+ */
+class ThreadAffinity {
+ public:
+  explicit ThreadAffinity(bool bound = false)
+      : bound_(bound), owner_(std::this_thread::get_id()) {}
+
+  bool isBound() const { return bound_; }
+
+  /**
+   * assert the calling thread is the owner of a bound engine, no-op in release builds.
+   */
+  void checkThread() const {
+    assert(!bound_ || owner_ == std::this_thread::get_id());
+    (void)owner_;
+  }
+
+ private:
+  const bool bound_;
+  const std::thread::id owner_;
+};
+
+/**
+ * A Mutex (std::mutex, std::recursive_mutex) skipped entirely when the affinity is bound,
+ * lock() only checks the thread in debug builds.
+ */
+template <typename Mutex>
+class AffinityMutex {
+ public:
+  explicit AffinityMutex(bool singleThread = false) : affinity_(singleThread) {}
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(AffinityMutex);
+
+  void lock() {
+    if (affinity_.isBound()) {
+      affinity_.checkThread();
+    } else {
+      mutex_.lock();
+    }
+  }
+
+  void unlock() {
+    if (!affinity_.isBound()) {
+      mutex_.unlock();
+    }
+  }
+
+  const ThreadAffinity& affinity() const { return affinity_; }
+
+ private:
+  ThreadAffinity affinity_;
+  Mutex mutex_;
+};
+
+}  // namespace script::utils
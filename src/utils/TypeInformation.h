@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 #ifdef __cpp_rtti
 #include <typeindex>
 #else
@@ -69,4 +71,20 @@ R scriptDynamicCast(T&& t) {
 
 #endif
 
+/**
+ * @return a new dense index, see classSlotOf
+ */
+size_t nextClassSlot();
+
+/**
+ * a small integer for each type, assigned on first use, so per-engine tables can be plain arrays.
+ * note: a type may get different slots in different shared libraries, use typeIndexOf as the
+ * fallback.
+ */
+template <typename T>
+size_t classSlotOf() {
+  static const size_t slot = nextClassSlot();
+  return slot;
+}
+
 }  // namespace script::internal
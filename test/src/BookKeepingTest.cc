@@ -234,4 +234,22 @@ TEST(BookKeeping, NonEmptyMoveAssign) {
   }
 }
 
+TEST(BookKeeping, Count) {
+  EXPECT_EQ(0, testKeeper.globalCount());
+  {
+    Ref r{1};
+    Ref copy = r;
+    Ref empty{0};
+    EXPECT_EQ(2, testKeeper.globalCount());
+
+    empty = std::move(copy);
+    EXPECT_EQ(2, testKeeper.globalCount());
+
+    r.reset();
+    EXPECT_EQ(1, testKeeper.globalCount());
+  }
+  EXPECT_EQ(0, testKeeper.globalCount());
+  EXPECT_EQ(0, testKeeper.weakCount());
+}
+
 }  // namespace script::test
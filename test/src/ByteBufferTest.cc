@@ -15,6 +15,9 @@
  * limitations under the License.
  */
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include "test.h"
 
 namespace script::test {
@@ -122,6 +125,26 @@ return view
   testByteBufferReadWrite(engine, ret);
 }
 
+#ifdef SCRIPTX_BACKEND_V8
+
+TEST_F(ByteBufferTest, V8Allocator) {
+  EngineScope engineScope(engine);
+  auto externalMemory = engine->getStats().externalMemory;
+
+  // pooled, malloc and mapped
+  for (size_t size : {size_t(100), size_t(100) * 1024, size_t(4) * 1024 * 1024}) {
+    StackFrameScope stackFrame;
+    auto buffer = ByteBuffer::newByteBuffer(size);
+    auto bytes = static_cast<uint8_t*>(buffer.getRawBytes());
+    EXPECT_EQ(bytes[0], 0);
+    EXPECT_EQ(bytes[size - 1], 0);
+    EXPECT_GE(engine->getStats().externalMemory, externalMemory + static_cast<int64_t>(size));
+    std::memset(bytes, 0xff, size);
+  }
+}
+
+#endif
+
 #ifdef SCRIPTX_LANG_JAVASCRIPT
 
 TEST_F(ByteBufferTest, DataView) {
@@ -218,6 +241,66 @@ return testBuffer:readInt8(5) == 2 and testBuffer:readInt8(6) == 0 and testBuffe
 #endif
 }
 
+TEST_F(ByteBufferTest, CommitRange) {
+  EngineScope engineScope(engine);
+  auto buffer = ByteBuffer::newByteBuffer(8);
+  auto bytes = static_cast<uint8_t*>(buffer.getRawBytes());
+  bytes[2] = 7;
+  buffer.commit(2, 1);
+
+  engine->set("testBuffer", buffer);
+  // reads 7 and writes 9
+  auto ret = engine->eval(TS().js("var view = new Int8Array(testBuffer); var v = view[2]; "
+                                  "view[2] = 9; v + 2")
+                              .lua("local v = testBuffer:readInt8(3) testBuffer:writeInt8(3, 9) "
+                                   "return v + 2")
+                              .select());
+  EXPECT_EQ(ret.asNumber().toInt32(), 9);
+
+  buffer.sync(2, 1);
+  EXPECT_EQ(bytes[2], 9);
+}
+
+#ifndef SCRIPTX_BACKEND_WEBASSEMBLY
+
+TEST_F(ByteBufferTest, MappedFile) {
+  auto path = ::testing::TempDir() + "scriptx_mapped_file.bin";
+  std::ofstream(path, std::ios::binary) << "scriptx";
+
+  EngineScope engineScope(engine);
+  {
+    StackFrameScope stackFrame;
+    auto buffer = ByteBuffer::newMappedFile(path);
+    ASSERT_EQ(buffer.byteLength(), 7);
+    EXPECT_EQ(std::memcmp(buffer.getRawBytes(), "scriptx", 7), 0);
+    static_cast<char*>(buffer.getRawBytes())[0] = 'S';
+    buffer.commit();
+    EXPECT_EQ(static_cast<char*>(buffer.getRawBytes())[0], 'S');
+  }
+
+  // copy-on-write by default
+  std::string content;
+  std::ifstream(path, std::ios::binary) >> content;
+  EXPECT_EQ(content, "scriptx");
+
+  {
+    StackFrameScope stackFrame;
+    auto buffer = ByteBuffer::newMappedFile(path, ByteBuffer::MapMode::kShared);
+    ASSERT_EQ(buffer.byteLength(), 7);
+    EXPECT_EQ(std::memcmp(buffer.getRawBytes(), "scriptx", 7), 0);
+    static_cast<char*>(buffer.getRawBytes())[0] = 'S';
+    buffer.commit();
+  }
+  // written through, even if the mapping is not released until gc
+  std::ifstream(path, std::ios::binary) >> content;
+  EXPECT_EQ(content, "Scriptx");
+
+  EXPECT_THROW(ByteBuffer::newMappedFile(path + ".missing"), Exception);
+  std::remove(path.c_str());
+}
+
+#endif
+
 TEST_F(ByteBufferTest, IsInstance) {
   EngineScope engineScope(engine);
   auto buffer = ByteBuffer::newByteBuffer(8);
@@ -0,0 +1,122 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test.h"
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(CoroutineTest);
+
+#if defined(SCRIPTX_FEATURE_COROUTINE) && defined(SCRIPTX_LANG_JAVASCRIPT)
+
+static Task<int> twice(ScriptEngine* engine, int value) {
+  co_await resumeOnEngine(engine);
+  EXPECT_EQ(EngineScope::currentEngine(), engine);
+  co_return value * 2;
+}
+
+static Task<std::string> describe(ScriptEngine* engine, int value) {
+  auto result = co_await twice(engine, value);
+  co_return "result:" + std::to_string(result);
+}
+
+static Task<> fail(ScriptEngine* engine) {
+  co_await resumeOnEngine(engine);
+  throw Exception("task failed");
+}
+
+static void drainQueue(ScriptEngine* engine) {
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+}
+
+TEST_F(CoroutineTest, BoundFunction) {
+  {
+    EngineScope scope(engine);
+    auto e = engine;
+    engine->set("describe", Function::newFunction([e](int value) { return describe(e, value); }));
+    engine->set("fail", Function::newFunction([e]() { return fail(e); }));
+    engine->eval(
+        "var result = null; var error = null;"
+        "describe(21).then(v => { result = v; });"
+        "fail().catch(e => { error = e.message; });");
+    EXPECT_TRUE(engine->get("result").isNull());
+  }
+
+  drainQueue(engine);
+
+  EngineScope scope(engine);
+  EXPECT_EQ(engine->get("result").asString().toString(), "result:42");
+  EXPECT_EQ(engine->get("error").asString().toString(), "task failed");
+}
+
+TEST_F(CoroutineTest, AwaitPromise) {
+  {
+    EngineScope scope(engine);
+    auto task = [](Local<Value> promise) -> Task<int> {
+      auto value = co_await awaitPromise(promise);
+      co_return value.get().asNumber().toInt32() + 1;
+    };
+    engine->set("plusOne", Function::newFunction(task));
+    engine->eval("var result = null; plusOne(Promise.resolve(1)).then(v => { result = v; });");
+  }
+
+  drainQueue(engine);
+
+  EngineScope scope(engine);
+  EXPECT_EQ(engine->get("result").asNumber().toInt32(), 2);
+}
+
+#ifndef SCRIPTX_BACKEND_WEBASSEMBLY
+
+static Task<> resumeOrCatch(ScriptEngine* engine, bool* dropped) {
+  try {
+    co_await resumeOnEngine(engine);
+  } catch (const Exception&) {
+    *dropped = true;
+  }
+}
+
+TEST(CoroutineShutdownTest, ResumeOnEngineDropped) {
+  auto queue = std::make_shared<utils::MessageQueue>();
+  auto engine = new ScriptEngineImpl(queue);
+
+  bool dropped = false;
+  {
+    EngineScope scope(engine);
+    resumeOrCatch(engine, &dropped).toPromise();
+  }
+  EXPECT_FALSE(dropped);
+  // the posted message is dropped, the coroutine resumes with an Exception
+  queue->shutdownNow();
+  EXPECT_TRUE(dropped);
+
+  // post fails
+  bool refused = false;
+  {
+    EngineScope scope(engine);
+    resumeOrCatch(engine, &refused).toPromise();
+  }
+  EXPECT_TRUE(refused);
+
+  engine->destroy();
+}
+
+#endif
+
+#endif
+
+}  // namespace script::test
@@ -15,6 +15,9 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <map>
+#include <thread>
 #include "test.h"
 
 namespace script::test {
@@ -41,6 +44,167 @@ TEST_F(EngineTest, Misc) {
 #endif
 }
 
+TEST_F(EngineTest, Stats) {
+  EngineScope scope(engine);
+  auto before = engine->getStats();
+
+  engine->adjustAssociatedMemory(1024);
+  Global<Value> global(String::newString("global"));
+  Weak<Value> weak(String::newString("weak"));
+  engine->gc();
+
+  auto stats = engine->getStats();
+  EXPECT_EQ(stats.externalMemory - before.externalMemory, 1024);
+  EXPECT_GE(stats.totalHeapSize, stats.usedHeapSize);
+#ifndef SCRIPTX_BACKEND_WEBASSEMBLY
+  EXPECT_EQ(stats.globalCount - before.globalCount, 1);
+  EXPECT_EQ(stats.weakCount - before.weakCount, 1);
+#endif
+#if defined(SCRIPTX_BACKEND_V8) || defined(SCRIPTX_BACKEND_LUA) || \
+    defined(SCRIPTX_BACKEND_QUICKJS)
+  EXPECT_GT(stats.usedHeapSize, 0);
+  EXPECT_GT(stats.gcCount, before.gcCount);
+#endif
+
+  engine->adjustAssociatedMemory(-1024);
+}
+
+TEST_F(EngineTest, GcCallback) {
+  int begin = 0;
+  int end = 0;
+  engine->setGcCallback([&](ScriptEngine::GcPhase phase, std::chrono::nanoseconds pauseTime) {
+    if (phase == ScriptEngine::GcPhase::kBegin) {
+      ++begin;
+    } else {
+      ++end;
+      EXPECT_GE(pauseTime.count(), 0);
+    }
+  });
+  engine->gc();
+  engine->setGcCallback({});
+
+#if defined(SCRIPTX_BACKEND_V8) || defined(SCRIPTX_BACKEND_LUA) || \
+    defined(SCRIPTX_BACKEND_QUICKJS) || defined(SCRIPTX_BACKEND_JAVASCRIPTCORE)
+  EXPECT_GT(begin, 0);
+#endif
+  EXPECT_EQ(begin, end);
+}
+
+#if defined(SCRIPTX_BACKEND_LUA) || defined(SCRIPTX_BACKEND_QUICKJS)
+
+TEST_F(EngineTest, HeapLimit) {
+  EngineScope scope(engine);
+  auto heapSize = engine->getHeapSize();
+  EXPECT_TRUE(engine->setHeapLimit(heapSize + 4 * 1024 * 1024));
+  EXPECT_THROW(
+      {
+        engine->eval(TS().js("var t = []; for (var i = 0; i < 10000000; i++) t.push('' + i);")
+                         .lua("local t = {} for i = 1, 10000000 do t[i] = tostring(i) end")
+                         .select());
+      },
+      Exception);
+
+  // still alive
+  EXPECT_EQ(engine->eval(TS().js("1 + 1").lua("return 1 + 1").select()).asNumber().toInt32(), 2);
+
+  // raised by callback
+  size_t calls = 0;
+  engine->setNearHeapLimitCallback([&](size_t heapLimit, size_t) {
+    ++calls;
+    return heapLimit * 2;
+  });
+  engine->setHeapLimit(engine->getHeapSize() + 1024 * 1024);
+  engine->eval(TS().js("var t = []; for (var i = 0; i < 100000; i++) t.push('' + i); t = null;")
+                   .lua("local t = {} for i = 1, 100000 do t[i] = tostring(i) end")
+                   .select());
+  EXPECT_GT(calls, 0);
+  engine->setNearHeapLimitCallback({});
+
+  engine->setHeapLimit(0);
+  engine->gc();
+}
+
+#endif
+
+#ifdef SCRIPTX_BACKEND_V8
+
+TEST_F(EngineTest, V8HeapLimit) {
+  EngineScope scope(engine);
+  // can't be removed or raised
+  EXPECT_FALSE(engine->setHeapLimit(0));
+  auto heapLimit = engine->getHeapSize() + 64 * 1024 * 1024;
+  EXPECT_TRUE(engine->setHeapLimit(heapLimit));
+  EXPECT_FALSE(engine->setHeapLimit(heapLimit * 2));
+  EXPECT_FALSE(engine->setHeapLimit(0));
+  EXPECT_TRUE(engine->setHeapLimit(heapLimit - 1024 * 1024));
+
+  EXPECT_THROW(
+      { engine->eval("var t = []; for (var i = 0; i < 100000000; i++) t.push('' + i);"); },
+      Exception);
+  engine->eval("t = null;");
+  engine->gc();
+}
+
+#endif
+
+#if defined(SCRIPTX_BACKEND_V8) || defined(SCRIPTX_BACKEND_QUICKJS) || \
+    (defined(SCRIPTX_BACKEND_LUA) && !defined(SCRIPTX_LUA_LUAJIT))
+
+TEST_F(EngineTest, ExecutionTimeout) {
+  EngineScope scope(engine);
+  {
+    ExecutionTimeout timeout(engine, std::chrono::milliseconds(50));
+    // can't be caught by script
+    EXPECT_THROW(
+        {
+          engine->eval(TS().js("while (true) { try { for (;;) {} } catch (e) {} }")
+                           .lua("while true do pcall(function() while true do end end) end")
+                           .select());
+        },
+        Exception);
+    EXPECT_TRUE(timeout.isTimedOut());
+  }
+
+  {
+    ExecutionTimeout timeout(engine, std::chrono::seconds(10));
+    EXPECT_EQ(engine->eval(TS().js("1 + 1").lua("return 1 + 1").select()).asNumber().toInt32(),
+              2);
+    EXPECT_FALSE(timeout.isTimedOut());
+  }
+}
+
+TEST_F(EngineTest, TerminateExecution) {
+  EngineScope scope(engine);
+  std::atomic_bool started = false;
+  engine->set("started", Function::newFunction([&started]() { started = true; }));
+
+  std::thread watchdog([this, &started]() {
+    while (!started) std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_TRUE(engine->terminateExecution());
+  });
+
+  EXPECT_THROW(
+      {
+        engine->eval(
+            TS().js("started(); while (true) {}").lua("started() while true do end").select());
+      },
+      Exception);
+  watchdog.join();
+
+  EXPECT_EQ(engine->eval(TS().js("1 + 1").lua("return 1 + 1").select()).asNumber().toInt32(), 2);
+}
+
+#elif defined(SCRIPTX_LUA_LUAJIT)
+
+TEST_F(EngineTest, LuaJitTerminateUnsupported) {
+  EXPECT_FALSE(engine->terminateExecution());
+  EngineScope scope(engine);
+  EXPECT_EQ(engine->eval("return 1 + 1").asNumber().toInt32(), 2);
+}
+
+#endif
+
 TEST_F(EngineTest, UserData) {
   EXPECT_TRUE(engine->getData() == nullptr);
   auto data = std::make_shared<bool>(false);
@@ -187,4 +351,140 @@ TEST_F(EngineTest, JsPromiseTest2) {
 }
 #endif
 
+#ifdef SCRIPTX_BACKEND_QUICKJS
+
+TEST_F(EngineTest, QjsBytecode) {
+  EngineScope scope(engine);
+  auto qjs = static_cast<qjs_backend::QjsEngine*>(engine);
+
+  auto bytecode = qjs->compileBytecode(
+      String::newString("var compiled = 1; function twice(x) { return x * 2; } twice(21);"),
+      String::newString("bytecode.js"));
+  EXPECT_FALSE(bytecode.empty());
+  // compiled only
+  EXPECT_TRUE(engine->get("compiled").isNull());
+
+  auto ret = qjs->evalBytecode(bytecode.data(), bytecode.size());
+  EXPECT_EQ(ret.asNumber().toInt32(), 42);
+  EXPECT_EQ(engine->get("compiled").asNumber().toInt32(), 1);
+
+  auto buffer = ByteBuffer::newByteBuffer(bytecode.data(), bytecode.size());
+  EXPECT_EQ(qjs->evalBytecode(buffer).asNumber().toInt32(), 42);
+
+  EXPECT_THROW(qjs->compileBytecode(String::newString("var ="), String::newString("bad.js")),
+               Exception);
+  std::vector<uint8_t> garbage(16, 0xff);
+  EXPECT_THROW(qjs->evalBytecode(garbage.data(), garbage.size()), Exception);
+}
+
+namespace {
+ClassDefine<void> qjsMathModule =
+    defineClass("Math")
+        .function("add", [](int a, int b) { return a + b; })
+        .property("version", []() { return String::newString("1.0"); })
+        .build();
+}
+
+TEST_F(EngineTest, QjsModules) {
+  EngineScope scope(engine);
+  auto qjs = static_cast<qjs_backend::QjsEngine*>(engine);
+
+  std::map<std::string, std::string> sources = {
+      {"lib/counter.js", "export let loads = 0; loads++; export const inc = (x) => x + loads;"},
+      {"lib/a.js", "import { inc } from './counter.js'; export const a = inc(1);"},
+      {"lib/b.js", "import { inc, loads } from './counter.js'; export const b = inc(2) + loads;"},
+  };
+  size_t loaderCalls = 0;
+  auto cache = std::make_shared<qjs_backend::QjsModuleCache>();
+  qjs->setModuleLoader(
+      [&](const std::string& name, std::string& source) {
+        ++loaderCalls;
+        auto it = sources.find(name);
+        if (it == sources.end()) return false;
+        source = it->second;
+        return true;
+      },
+      cache);
+  qjs->registerNativeModule("native:math", qjsMathModule);
+
+  qjs->evalModule(String::newString(u8R"(
+      import { a } from './lib/a.js';
+      import { b } from './lib/b.js';
+      import { add, version } from 'native:math';
+      import math from 'native:math';
+      globalThis.result = [a, b, add(1, 2), version, math.add(3, 4)].join();
+  )"),
+                  String::newString("main.js"));
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+
+  // counter.js is evaluated once, and shared
+  EXPECT_EQ(engine->get("result").asString().toString(), "2,4,3,1.0,7");
+  EXPECT_EQ(loaderCalls, 3);
+  EXPECT_EQ(cache->size(), 3);
+
+  EXPECT_THROW(qjs->evalModule(String::newString("import './missing.js';"),
+                               String::newString("broken.js")),
+               Exception);
+  EXPECT_THROW(qjs->evalModule(String::newString("throw new Error('top level');"),
+                               String::newString("throws.js")),
+               Exception);
+
+  // another engine loads the bytecode from the cache
+  auto other = new ScriptEngineImpl();
+  {
+    EngineScope otherScope(other);
+    auto otherQjs = static_cast<qjs_backend::QjsEngine*>(other);
+    otherQjs->setModuleLoader(
+        [](const std::string& name, std::string&) {
+          ADD_FAILURE() << "not loaded from cache: " << name;
+          return false;
+        },
+        cache);
+    otherQjs->registerNativeModule("native:math", qjsMathModule);
+    otherQjs->evalModule(String::newString("import { a } from './lib/a.js';"
+                                           "import { b } from './lib/b.js';"
+                                           "globalThis.result = [a, b].join();"),
+                         String::newString("main.js"));
+    other->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+    EXPECT_EQ(other->get("result").asString().toString(), "2,4");
+  }
+  other->destroy();
+  EXPECT_EQ(cache->size(), 3);
+}
+
+TEST_F(EngineTest, QjsMicrotaskBudget) {
+  auto qjs = static_cast<qjs_backend::QjsEngine*>(engine);
+  auto done = [this]() {
+    EngineScope scope(engine);
+    return engine->get("done").asNumber().toInt32();
+  };
+
+  {
+    EngineScope scope(engine);
+    qjs->setMicrotaskBudget(10);
+    engine->eval(
+        "var done = 0; var p = Promise.resolve();"
+        "for (var i = 0; i < 100; i++) p = p.then(() => done++);");
+  }
+
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  EXPECT_GT(done(), 0);
+  EXPECT_LE(done(), 10);
+
+  // the rest is re-posted
+  for (int i = 0; i < 20 && done() < 100; ++i) {
+    engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  }
+  EXPECT_EQ(done(), 100);
+
+  auto stats = engine->getStats();
+  EXPECT_GE(stats.microtaskCount, 100);
+  EXPECT_GE(stats.microtaskDrainCount, 10);
+
+  EngineScope scope(engine);
+  qjs->setMicrotaskBudget(0);
+}
+
+#endif
+
 }  // namespace script::test
@@ -139,6 +139,57 @@ TEST_F(InteroperateTest, Lua) {
   EXPECT_EQ(ret.asNumber().toInt32(), 3);
 }
 
+TEST_F(InteroperateTest, LuaPrimitiveFunction) {
+  EngineScope scope(engine);
+  engine->set("add", lua_interop::newPrimitiveFunction(+[](int a, double b) { return a + b; }));
+  engine->set("negate", lua_interop::newPrimitiveFunction(+[](bool b) { return !b; }));
+  engine->set("fail", lua_interop::newPrimitiveFunction(+[]() { throw Exception("failed"); }));
+
+  EXPECT_DOUBLE_EQ(engine->eval("return add(1, 2.5)").asNumber().toDouble(), 3.5);
+  EXPECT_EQ(engine->eval("return negate(false)").asBoolean().value(), true);
+  EXPECT_THROW(engine->eval("return add(1)"), Exception);
+  EXPECT_THROW(engine->eval("return add('1', 2)"), Exception);
+  EXPECT_THROW(engine->eval("fail()"), Exception);
+
+  // integer parameters take integral numbers in range only
+  EXPECT_DOUBLE_EQ(engine->eval("return add(2.0, 0)").asNumber().toDouble(), 2);
+  EXPECT_THROW(engine->eval("return add(2.5, 0)"), Exception);
+  EXPECT_THROW(engine->eval("return add(1e300, 0)"), Exception);
+  EXPECT_THROW(engine->eval("return add(0/0, 0)"), Exception);
+  EXPECT_THROW(engine->eval("return add(4294967296, 0)"), Exception);
+
+  auto sum = engine->eval(
+      "local s = 0\n"
+      "for i = 1, 1000 do s = add(s, i) end\n"
+      "return s");
+  EXPECT_EQ(sum.asNumber().toInt64(), 500500);
+}
+
+#ifdef SCRIPTX_LUA_LUAJIT
+
+TEST_F(InteroperateTest, LuaJitFfiPointer) {
+  struct Vec3 {
+    double x, y, z;
+  };
+  Vec3 vec{1, 2, 3};
+
+  EngineScope scope(engine);
+  lua_interop::ffiDefine("typedef struct { double x, y, z; } Vec3;");
+  // defined once per engine
+  lua_interop::ffiDefine("typedef struct { double x, y, z; } Vec3;");
+  engine->set("vec", lua_interop::ffiPointer("Vec3*", &vec));
+
+  auto sum = engine->eval(
+      "local s = 0\n"
+      "for i = 1, 1000 do s = s + vec.x + vec.y + vec.z end\n"
+      "vec.z = 42\n"
+      "return s");
+  EXPECT_DOUBLE_EQ(sum.asNumber().toDouble(), 6000);
+  EXPECT_DOUBLE_EQ(vec.z, 42);
+}
+
+#endif
+
 #endif
 
 }  // namespace script::test
\ No newline at end of file
@@ -53,6 +53,33 @@ TEST(MessageQueue, LoopOnce) {
   queue.shutdown(true);
 }
 
+TEST(MessageQueue, Stats) {
+  Message nop([](Message&) {}, nullptr);
+  MessageQueue queue;
+
+  auto stats = queue.stats();
+  EXPECT_EQ(stats.messageCount, 0);
+  EXPECT_EQ(stats.dueMessageCount, 0);
+  EXPECT_EQ(stats.oldestDueMessageAge.count(), 0);
+
+  queue.postMessage(nop);
+  queue.postMessage(nop, std::chrono::seconds(10));
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+  stats = queue.stats();
+  EXPECT_EQ(stats.messageCount, 2);
+  EXPECT_EQ(stats.dueMessageCount, 1);
+  EXPECT_GE(stats.oldestDueMessageAge, std::chrono::milliseconds(2));
+
+  queue.loopQueue(MessageQueue::LoopType::kLoopOnce);
+  stats = queue.stats();
+  EXPECT_EQ(stats.messageCount, 1);
+  EXPECT_EQ(stats.dueMessageCount, 0);
+  EXPECT_EQ(stats.oldestDueMessageAge.count(), 0);
+
+  queue.shutdownNow(true);
+}
+
 TEST(MessageQueue, Interrupt) {
   // normal loop once
   std::atomic_int32_t count = 0;
@@ -826,6 +826,16 @@ TEST_F(NativeTest, InstanceOfTest) {
 
     EXPECT_FALSE(func.call({}, Object::newObject()).asBoolean().value());
     EXPECT_FALSE(func.call({}, Number::newNumber(0)).asBoolean().value());
+
+    EXPECT_FALSE(engine->isInstanceOf<InstanceOfTest>(ByteBuffer::newByteBuffer(8)));
+    EXPECT_EQ(engine->getNativeInstance<InstanceOfTest>(Object::newObject()), nullptr);
+
+#ifdef SCRIPTX_BACKEND_V8
+    // script subclass
+    ins = engine->eval("new (class extends InstanceOfTest {})()").asObject();
+    EXPECT_TRUE(engine->isInstanceOf<InstanceOfTest>(ins));
+    EXPECT_TRUE(engine->getNativeInstance<InstanceOfTest>(ins) != nullptr);
+#endif
   } catch (const Exception& e) {
     FAIL() << e;
   }
@@ -0,0 +1,146 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <thread>
+#include "test.h"
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(PromiseTest);
+
+#ifdef SCRIPTX_LANG_JAVASCRIPT
+
+static void drainQueue(ScriptEngine* engine) {
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+}
+
+TEST_F(PromiseTest, ResolveFromAnotherThread) {
+  {
+    EngineScope scope(engine);
+    auto [promise, resolver] = Promise::newPromise();
+    EXPECT_TRUE(Promise::isPromise(promise));
+    engine->set("p", promise);
+    engine->eval("var result = null; p.then(v => { result = v; });");
+
+    std::thread([resolver = resolver]() {
+      resolver->resolve([]() { return String::newString("done"); });
+      EXPECT_FALSE(resolver->reject("too late"));
+    }).join();
+    EXPECT_TRUE(resolver->isSettled());
+    EXPECT_TRUE(engine->get("result").isNull());
+  }
+
+  drainQueue(engine);
+
+  EngineScope scope(engine);
+  EXPECT_EQ(engine->get("result").asString().toString(), "done");
+}
+
+TEST_F(PromiseTest, Reject) {
+  {
+    EngineScope scope(engine);
+    auto capability = Promise::newPromise();
+    engine->set("p", capability.promise);
+    engine->eval("var error = null; p.catch(e => { error = e.message; });");
+    capability.resolver->reject("failed");
+  }
+
+  drainQueue(engine);
+
+  EngineScope scope(engine);
+  EXPECT_EQ(engine->get("error").asString().toString(), "failed");
+}
+
+TEST_F(PromiseTest, RejectOnDestroy) {
+  {
+    EngineScope scope(engine);
+    auto capability = Promise::newPromise();
+    engine->set("p", capability.promise);
+    engine->eval("var rejected = false; p.catch(() => { rejected = true; });");
+  }
+
+  drainQueue(engine);
+
+  EngineScope scope(engine);
+  EXPECT_TRUE(engine->get("rejected").asBoolean().value());
+}
+
+#ifndef SCRIPTX_BACKEND_WEBASSEMBLY
+
+TEST(PromiseShutdownTest, SettleAfterShutdown) {
+  auto queue = std::make_shared<utils::MessageQueue>();
+  auto engine = new ScriptEngineImpl(queue);
+
+  std::shared_ptr<PromiseResolver> resolver;
+  {
+    EngineScope scope(engine);
+    resolver = Promise::newPromise().resolver;
+  }
+  queue->shutdownNow();
+
+  // the discarded settlement holds the last State, which must not be released here
+  std::thread([resolver = std::move(resolver)]() mutable {
+    EXPECT_FALSE(resolver->resolve([]() { return Local<Value>(); }));
+    resolver.reset();
+  }).join();
+
+  engine->destroy();
+}
+
+#endif
+
+TEST_F(PromiseTest, ToFuture) {
+  std::future<SerializedValue> fulfilled;
+  std::future<SerializedValue> rejected;
+  {
+    EngineScope scope(engine);
+    fulfilled = Promise::toFuture(engine->eval("Promise.resolve({answer: 42})"));
+    rejected = Promise::toFuture(engine->eval("Promise.reject(new Error('nope'))"));
+  }
+
+  drainQueue(engine);
+
+  ASSERT_EQ(fulfilled.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  auto value = fulfilled.get();
+
+  ASSERT_EQ(rejected.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  try {
+    rejected.get();
+    FAIL() << "should throw";
+  } catch (const Exception& e) {
+    EXPECT_NE(e.message().find("nope"), std::string::npos) << e.message();
+  }
+
+  EngineScope scope(engine);
+  EXPECT_EQ(value.deserialize().asObject().get("answer").asNumber().toInt32(), 42);
+
+  // plain value
+  auto plain = Promise::toFuture(Number::newNumber(1));
+  EXPECT_EQ(plain.get().deserialize().asNumber().toInt32(), 1);
+}
+
+#elif defined(SCRIPTX_LANG_LUA)
+
+TEST_F(PromiseTest, NotSupported) {
+  EngineScope scope(engine);
+  EXPECT_THROW(Promise::newPromise(), Exception);
+}
+
+#endif
+
+}  // namespace script::test
@@ -77,6 +77,66 @@ TEST_F(ReferenceTest, GlobalVector) {
   v.push_back({});
 }
 
+TEST_F(ReferenceTest, GlobalWeakReuse) {
+  EngineScope engineScope(engine);
+  std::vector<Global<Value>> globals;
+  std::vector<Weak<Value>> weaks;
+  auto keep = Array::newArray();
+
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 100; ++i) {
+      StackFrameScope stack;
+      auto value = String::newString(std::to_string(round * 100 + i));
+      keep.add(value);
+      globals.emplace_back(value);
+      weaks.emplace_back(value);
+    }
+    // free every other handle, the freed slots are reused by the next round
+    for (size_t i = 0; i < globals.size(); i += 2) {
+      globals[i].reset();
+      weaks[i].reset();
+    }
+  }
+
+  for (size_t i = 0; i < globals.size(); ++i) {
+    if (globals[i].isEmpty()) continue;
+    EXPECT_EQ(globals[i].get().asString().toString(), std::to_string(i));
+    EXPECT_EQ(weaks[i].get().asString().toString(), std::to_string(i));
+  }
+
+#ifdef SCRIPTX_BACKEND_LUA
+  // 100 ids, then 50 reused and 50 new in each of the next 2 rounds
+  EXPECT_EQ(luaWeakIdCount(), 200);
+  for (int i = 0; i < 1000; ++i) {
+    Weak<Value> weak(keep);
+  }
+  EXPECT_EQ(luaWeakIdCount(), 200);
+
+  // Globals and Weaks live in the registry, not in _G
+  auto countGlobals = [this]() {
+    return engine->eval("local n = 0 for _ in pairs(_G) do n = n + 1 end return n")
+        .asNumber()
+        .toInt32();
+  };
+  auto globalCount = countGlobals();
+  {
+    StackFrameScope stack;
+    std::vector<Global<Value>> more(10, Global<Value>(Object::newObject()));
+    Weak<Value> weak(Object::newObject());
+    EXPECT_EQ(countGlobals(), globalCount);
+  }
+
+  Weak<Value> collected;
+  {
+    StackFrameScope stack;
+    collected = Object::newObject();
+  }
+  engine->gc();
+  EXPECT_FALSE(collected.isEmpty());
+  EXPECT_TRUE(collected.getValue().isNull());
+#endif
+}
+
 TEST_F(ReferenceTest, Weak) {
   Weak<String> weak;
   Global<String> global;
@@ -0,0 +1,84 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+#include "test.h"
+
+namespace script::utils::test {
+
+TEST(SamplingTracer, Buckets) {
+  for (uint64_t v : {0ull, 1ull, 15ull, 16ull, 17ull, 100ull, 1000ull, 123456789ull, ~0ull}) {
+    auto index = SamplingTracer::bucketIndex(v);
+    ASSERT_LT(index, SamplingTracer::kBucketCount);
+    EXPECT_LE(SamplingTracer::bucketLowerBound(index), v);
+    if (index + 1 < SamplingTracer::kBucketCount) {
+      EXPECT_GT(SamplingTracer::bucketLowerBound(index + 1), v);
+    }
+  }
+}
+
+TEST(SamplingTracer, Record) {
+  SamplingTracer tracer;
+  Tracer::setDelegate(&tracer);
+
+  auto worker = [] {
+    for (int i = 0; i < 100; ++i) {
+      Tracer outer(nullptr, "outer");
+      Tracer inner(nullptr, "inner");
+    }
+  };
+  worker();
+  std::thread(worker).join();
+
+  Tracer::setDelegate(nullptr);
+
+  auto stats = tracer.snapshot();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats[0].traceName, "inner");
+  EXPECT_EQ(stats[1].traceName, "outer");
+  EXPECT_EQ(stats[0].count, 200);
+  EXPECT_EQ(stats[1].count, 200);
+  EXPECT_LE(stats[0].percentile(0.5), stats[0].percentile(0.99));
+  EXPECT_LE(stats[0].percentile(0.99), stats[0].maxNanos);
+
+  auto dump = tracer.dump();
+  EXPECT_NE(dump.find("outer 200"), std::string::npos) << dump;
+
+  tracer.reset();
+  stats = tracer.snapshot();
+  EXPECT_EQ(stats[0].count, 0);
+  EXPECT_EQ(stats[0].percentile(0.5), 0);
+}
+
+TEST(SamplingTracer, Sampling) {
+  SamplingTracer tracer(4);
+  Tracer::setDelegate(&tracer);
+  for (int i = 0; i < 1000; ++i) {
+    Tracer outer(nullptr, "outer");
+    Tracer inner(nullptr, "inner");
+  }
+  Tracer::setDelegate(nullptr);
+
+  // 2000 traces, 1 in 4 sampled on average, and not biased to either name
+  auto stats = tracer.snapshot();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_GT(stats[0].count, 100);
+  EXPECT_GT(stats[1].count, 100);
+  EXPECT_LT(stats[0].count + stats[1].count, 1000);
+}
+
+}  // namespace script::utils::test
@@ -15,6 +15,8 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <iostream>
 #include "test.h"
 // include private class
 #include "../../src/utils/ThreadLocal.h"
@@ -127,6 +129,36 @@ TEST_F(EngineScopeTest, StackFrameScope) {
   EXPECT_STREQ(val.asString().toString().c_str(), "InsideStack");
 }
 
+TEST_F(EngineScopeTest, StackFrameScopeLoop) {
+  EngineScope engineScope(engine);
+  auto array = Array::newArray();
+  for (int i = 0; i < 100; ++i) {
+    array.add(Number::newNumber(i));
+  }
+
+  // scope per loop body, the Locals of each iteration are released
+  Local<Value> last;
+  for (int round = 0; round < 1000; ++round) {
+    StackFrameScope outer;
+    for (size_t i = 0; i < array.size(); ++i) {
+      StackFrameScope stack;
+      auto value = array.get(i);
+      auto text = String::newString(std::to_string(value.asNumber().toInt32()));
+      if (i + 1 == array.size()) {
+        last = stack.returnValue(text);
+      }
+    }
+    EXPECT_EQ(last.asString().toString(), "99");
+  }
+
+  auto object = Object::newObject();
+  for (int i = 0; i < 1000; ++i) {
+    StackFrameScope stack;
+    object.set("key" + std::to_string(i), i);
+  }
+  EXPECT_EQ(object.getKeys().size(), 1000u);
+}
+
 TEST_F(EngineScopeTest, TwoThreads) {
   EXPECT_EQ(script::EngineScope::currentEngine(), nullptr);
 
@@ -171,4 +203,77 @@ TEST_F(EngineScopeTest, ThreadLocal) {
   EXPECT_EQ(script::internal::getThreadLocal(threadLocal_2), 0);
 }
 
+namespace {
+
+constexpr auto kScopeBenchmarkIterations = 100000;
+
+template <typename Fn>
+void runScopeBenchmark(const char* name, Fn&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kScopeBenchmarkIterations; ++i) {
+    fn();
+  }
+  auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+  std::cout << name << ": " << nanos / kScopeBenchmarkIterations << " ns/op" << std::endl;
+}
+
+}  // namespace
+
+TEST_F(EngineScopeTest, Benchmark_ScopeChurn) {
+  runScopeBenchmark("EngineScope enter/exit", [this]() { EngineScope scope(engine); });
+
+  EngineScope scope(engine);
+  runScopeBenchmark("EngineScope nested same engine", [this]() {
+    EngineScope nested(engine);
+    EXPECT_EQ(EngineScope::currentEngine(), engine);
+  });
+  runScopeBenchmark("ExitEngineScope + EngineScope", [this]() {
+    ExitEngineScope exit;
+    EngineScope reenter(engine);
+  });
+  runScopeBenchmark("StackFrameScope", []() { StackFrameScope stack; });
+}
+
+#if defined(SCRIPTX_BACKEND_V8) || defined(SCRIPTX_BACKEND_QUICKJS) || \
+    defined(SCRIPTX_BACKEND_LUA)
+
+static ScriptEngine* newSingleThreadEngine() {
+  constexpr auto mode = ScriptEngine::ThreadMode::kSingleThread;
+#if defined(SCRIPTX_BACKEND_V8)
+  return new ScriptEngineImpl({}, mode);
+#elif defined(SCRIPTX_BACKEND_QUICKJS)
+  return new ScriptEngineImpl({}, {}, mode);
+#else
+  return new ScriptEngineImpl({}, {}, {}, mode);
+#endif
+}
+
+TEST_F(EngineScopeTest, SingleThreadMode) {
+  auto single = newSingleThreadEngine();
+  {
+    EngineScope scope(single);
+    EXPECT_EQ(EngineScope::currentEngine(), single);
+    {
+      // interleave with a multi-thread engine
+      EngineScope other(engine);
+      EXPECT_EQ(EngineScope::currentEngine(), engine);
+      {
+        ExitEngineScope exit;
+        EngineScope reenter(single);
+        EXPECT_EQ(EngineScope::currentEngine(), single);
+      }
+    }
+    single->set("value", Number::newNumber(1));
+    EXPECT_EQ(single->get("value").asNumber().toInt32(), 1);
+  }
+
+  runScopeBenchmark("EngineScope enter/exit, single thread",
+                    [single]() { EngineScope scope(single); });
+  single->destroy();
+}
+
+#endif
+
 }  // namespace script::test
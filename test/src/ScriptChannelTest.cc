@@ -0,0 +1,170 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "test.h"
+
+namespace script::utils::test {
+
+TEST(ScriptChannel, FullAndEmpty) {
+  auto channel = ScriptChannel::create(sizeof(int), 3);
+  EXPECT_EQ(channel->capacity(), 4);
+  EXPECT_EQ(channel->recordSize(), sizeof(int));
+
+  int value = 0;
+  EXPECT_FALSE(channel->tryPop(&value));
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(channel->tryPush(&i));
+  }
+  EXPECT_EQ(channel->size(), 4);
+  EXPECT_FALSE(channel->tryPush(&value));
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(channel->tryPop(&value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_EQ(channel->size(), 0);
+  EXPECT_FALSE(channel->tryPop(&value));
+
+  auto slot = channel->tryBeginPush();
+  ASSERT_NE(slot, nullptr);
+  *static_cast<int*>(slot) = 42;
+  // not visible until ended
+  EXPECT_EQ(channel->tryBeginPop(), nullptr);
+  EXPECT_TRUE(channel->endPush(slot));
+  // ended twice
+  EXPECT_FALSE(channel->endPush(slot));
+
+  auto read = channel->tryBeginPop();
+  ASSERT_EQ(read, slot);
+  EXPECT_EQ(*static_cast<const int*>(read), 42);
+  EXPECT_TRUE(channel->endPop());
+  // empty, nothing changed
+  EXPECT_FALSE(channel->endPop());
+
+  // never reserved
+  EXPECT_FALSE(channel->endPush(channel->storage().get()));
+  EXPECT_TRUE(channel->tryPush(&value));
+  ASSERT_TRUE(channel->tryPop(&value));
+
+  EXPECT_THROW(ScriptChannel::create(0, 4), std::invalid_argument);
+  EXPECT_THROW(ScriptChannel::create(SIZE_MAX / 2, 4), std::invalid_argument);
+}
+
+#ifndef SCRIPTX_BACKEND_WEBASSEMBLY
+
+TEST(ScriptChannel, MultiProducer) {
+  constexpr int kProducers = 4;
+  constexpr uint32_t kCount = 20000;
+  auto channel = ScriptChannel::create(sizeof(uint64_t), 64, ScriptChannel::Mode::kMultiProducer);
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&channel, p] {
+      for (uint32_t i = 0; i < kCount; ++i) {
+        uint64_t record = (static_cast<uint64_t>(p) << 32u) | i;
+        while (!channel->tryPush(&record)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // records of each producer arrive in order
+  std::vector<uint32_t> next(kProducers, 0);
+  for (uint32_t received = 0; received < kProducers * kCount;) {
+    uint64_t record;
+    if (!channel->tryPop(&record)) {
+      std::this_thread::yield();
+      continue;
+    }
+    auto p = static_cast<size_t>(record >> 32u);
+    ASSERT_LT(p, next.size());
+    ASSERT_EQ(static_cast<uint32_t>(record), next[p]);
+    next[p]++;
+    received++;
+  }
+
+  for (auto& t : producers) {
+    t.join();
+  }
+  EXPECT_EQ(channel->size(), 0);
+}
+
+#endif
+
+}  // namespace script::utils::test
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(ScriptChannelTest);
+
+TEST_F(ScriptChannelTest, ScriptObject) {
+  auto channel = utils::ScriptChannel::create(sizeof(uint32_t), 2);
+  EngineScope scope(engine);
+
+  auto obj = channel->newScriptObject();
+  EXPECT_EQ(obj.get("recordSize").asNumber().toInt32(), 4);
+  EXPECT_EQ(obj.get("capacity").asNumber().toInt32(), 2);
+  auto buffer = obj.get("buffer").asByteBuffer();
+  EXPECT_EQ(buffer.byteLength(), 8);
+
+  auto push = obj.get("push").asFunction();
+  auto pop = obj.get("pop").asFunction();
+  auto bytes = ByteBuffer::newByteBuffer(sizeof(uint32_t));
+
+  uint32_t value = 7;
+  ASSERT_TRUE(channel->tryPush(&value));
+  EXPECT_EQ(obj.get("size").asFunction().call().asNumber().toInt32(), 1);
+
+  ASSERT_TRUE(pop.call({}, bytes).asBoolean().value());
+  bytes.sync();
+  EXPECT_EQ(*static_cast<uint32_t*>(bytes.getRawBytes()), 7);
+  EXPECT_FALSE(pop.call({}, bytes).asBoolean().value());
+
+  *static_cast<uint32_t*>(bytes.getRawBytes()) = 9;
+  bytes.commit();
+  ASSERT_TRUE(push.call({}, bytes).asBoolean().value());
+  ASSERT_TRUE(channel->tryPop(&value));
+  EXPECT_EQ(value, 9);
+
+  // zero copy, through the shared buffer
+  auto slot = obj.get("beginPush").asFunction().call().asNumber().toInt32();
+  ASSERT_GE(slot, 0);
+  buffer.sync();
+  static_cast<uint32_t*>(buffer.getRawBytes())[slot] = 11;
+  buffer.commit();
+  obj.get("endPush").asFunction().call({}, slot);
+  ASSERT_TRUE(channel->tryPop(&value));
+  EXPECT_EQ(value, 11);
+
+  EXPECT_EQ(obj.get("beginPop").asFunction().call().asNumber().toInt32(), -1);
+
+  // misuse from script is rejected, and the channel keeps working
+  EXPECT_THROW(obj.get("endPop").asFunction().call(), Exception);
+  EXPECT_THROW(obj.get("endPush").asFunction().call({}, slot), Exception);
+  EXPECT_THROW(obj.get("endPush").asFunction().call({}, 5), Exception);
+  value = 13;
+  ASSERT_TRUE(channel->tryPush(&value));
+  ASSERT_TRUE(channel->tryPop(&value));
+  EXPECT_EQ(value, 13);
+}
+
+}  // namespace script::test
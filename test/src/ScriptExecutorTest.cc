@@ -0,0 +1,132 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <future>
+#include <set>
+#include "test.h"
+
+namespace script::utils::test {
+
+// WebAssembly has only one engine on the main thread
+#ifndef SCRIPTX_BACKEND_WEBASSEMBLY
+
+static ScriptEngine* newEngine(const std::shared_ptr<MessageQueue>& queue) {
+  return new ScriptEngineImpl(queue);
+}
+
+TEST(ScriptExecutor, RunOnEngineThread) {
+  ScriptExecutor::Options options;
+  options.engineCount = 2;
+  options.pinThreads = true;
+  ScriptExecutor executor(newEngine, options);
+  ASSERT_EQ(executor.engineCount(), 2);
+
+  std::atomic_int count = 0;
+  for (size_t i = 0; i < executor.engineCount(); ++i) {
+    executor.post(i, [&, i](ScriptEngine& engine) {
+      EXPECT_EQ(&engine, executor.engine(i));
+      EXPECT_EQ(EngineScope::currentEngine(), &engine);
+      engine.set("value", static_cast<int>(i));
+      EXPECT_EQ(engine.get("value").asNumber().toInt32(), static_cast<int>(i));
+      count++;
+    });
+  }
+
+  executor.shutdown(true);
+  EXPECT_EQ(count, 2);
+}
+
+TEST(ScriptExecutor, RouteByKey) {
+  ScriptExecutor::Options options;
+  options.engineCount = 4;
+  ScriptExecutor executor(newEngine, options);
+
+  std::set<size_t> used;
+  for (uint64_t key = 0; key < 1000; ++key) {
+    auto index = executor.engineIndexForKey(key);
+    ASSERT_LT(index, executor.engineCount());
+    EXPECT_EQ(index, executor.engineIndexForKey(key));
+    used.insert(index);
+  }
+  EXPECT_EQ(used.size(), executor.engineCount());
+
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  for (int i = 0; i < 100; ++i) {
+    executor.postByKey("same-key", [&](ScriptEngine&) {
+      std::lock_guard<std::mutex> lk(mutex);
+      threads.insert(std::this_thread::get_id());
+    });
+  }
+
+  executor.shutdown(true);
+  EXPECT_EQ(threads.size(), 1);
+}
+
+TEST(ScriptExecutor, LeastLoadedAndBackPressure) {
+  ScriptExecutor::Options options;
+  options.engineCount = 2;
+  options.maxMessageInQueue = 2;
+  ScriptExecutor executor(newEngine, options);
+
+  std::promise<void> release;
+  auto blocker = release.get_future().share();
+  std::promise<void> running;
+
+  executor.post(0, [&running, blocker](ScriptEngine&) {
+    running.set_value();
+    blocker.wait();
+  });
+  running.get_future().wait();
+  executor.post(0, [](ScriptEngine&) {});
+
+  EXPECT_EQ(executor.pendingTaskCount(0), 2);
+  EXPECT_EQ(executor.leastLoadedEngineIndex(), 1);
+  EXPECT_EQ(executor.tryPost(0, [](ScriptEngine&) {}), 0);
+  EXPECT_NE(executor.tryPost(1, [](ScriptEngine&) {}), 0);
+
+  release.set_value();
+  executor.shutdown(true);
+  EXPECT_EQ(executor.pendingTaskCount(0), 0);
+  EXPECT_EQ(executor.pendingTaskCount(1), 0);
+
+  // the workers are gone, posts fail instead of blocking or never running
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(executor.post(0, [](ScriptEngine&) {}), 0);
+  }
+  EXPECT_EQ(executor.tryPost(1, [](ScriptEngine&) {}), 0);
+  EXPECT_EQ(executor.pendingTaskCount(0), 0);
+}
+
+TEST(ScriptExecutor, FactoryThrows) {
+  ScriptExecutor::Options options;
+  options.engineCount = 2;
+  EXPECT_THROW(
+      {
+        ScriptExecutor executor(
+            [](const std::shared_ptr<MessageQueue>&) -> ScriptEngine* {
+              throw std::runtime_error("no engine");
+            },
+            options);
+      },
+      std::runtime_error);
+}
+
+#endif
+
+}  // namespace script::utils::test
@@ -0,0 +1,193 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test.h"
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(SerializedValueTest);
+
+TEST_F(SerializedValueTest, Primitives) {
+  EngineScope scope(engine);
+
+  auto roundTrip = [](const Local<Value>& value) {
+    return SerializedValue::serialize(value).deserialize();
+  };
+
+  EXPECT_TRUE(roundTrip({}).isNull());
+  EXPECT_TRUE(roundTrip(Boolean::newBoolean(true)).asBoolean().value());
+  EXPECT_FALSE(roundTrip(Boolean::newBoolean(false)).asBoolean().value());
+  EXPECT_EQ(roundTrip(Number::newNumber(0)).asNumber().toInt32(), 0);
+  EXPECT_EQ(roundTrip(Number::newNumber(-42)).asNumber().toInt32(), -42);
+  EXPECT_EQ(roundTrip(Number::newNumber(INT32_MIN)).asNumber().toInt32(), INT32_MIN);
+  EXPECT_EQ(roundTrip(Number::newNumber(3.25)).asNumber().toDouble(), 3.25);
+  EXPECT_EQ(roundTrip(Number::newNumber(1e300)).asNumber().toDouble(), 1e300);
+  EXPECT_EQ(roundTrip(String::newString(u8"hello 世界")).asString().toU8string(),
+            u8"hello 世界");
+  EXPECT_EQ(roundTrip(String::newString("")).asString().toString(), "");
+}
+
+TEST_F(SerializedValueTest, Nested) {
+  EngineScope scope(engine);
+
+  auto value = engine->eval(
+      TS().js("({name: 'x', list: [1, 'two', {three: 3}], flag: false})")
+          .lua("return {name = 'x', list = {1, 'two', {three = 3}}, flag = false}")
+          .select());
+  auto data = SerializedValue::serialize(value);
+  EXPECT_FALSE(data.isEmpty());
+  EXPECT_EQ(data.byteBufferCount(), 0);
+
+  auto copy = data.deserialize();
+  ASSERT_TRUE(copy.isObject());
+  auto obj = copy.asObject();
+  EXPECT_EQ(obj.get("name").asString().toString(), "x");
+  EXPECT_FALSE(obj.get("flag").asBoolean().value());
+
+  auto list = obj.get("list").asArray();
+  ASSERT_EQ(list.size(), 3);
+  EXPECT_EQ(list.get(0).asNumber().toInt32(), 1);
+  EXPECT_EQ(list.get(1).asString().toString(), "two");
+  EXPECT_EQ(list.get(2).asObject().get("three").asNumber().toInt32(), 3);
+}
+
+TEST_F(SerializedValueTest, ByteBuffer) {
+  EngineScope scope(engine);
+
+  auto buffer = ByteBuffer::newByteBuffer(4);
+  auto bytes = static_cast<uint8_t*>(buffer.getRawBytes());
+  for (uint8_t i = 0; i < 4; ++i) {
+    bytes[i] = i + 1;
+  }
+  buffer.commit();
+
+  auto obj = Object::newObject();
+  obj.set("buffer", buffer);
+  auto data = SerializedValue::serialize(obj);
+  EXPECT_EQ(data.byteBufferCount(), 1);
+
+  // the serialized content is a snapshot
+  bytes[0] = 100;
+  buffer.commit();
+
+  auto copy = data.deserialize().asObject().get("buffer");
+  ASSERT_TRUE(copy.isByteBuffer());
+  auto copyBuffer = copy.asByteBuffer();
+  copyBuffer.sync();
+  ASSERT_EQ(copyBuffer.byteLength(), 4);
+  auto copyBytes = static_cast<uint8_t*>(copyBuffer.getRawBytes());
+  EXPECT_EQ(copyBytes[0], 1);
+  EXPECT_EQ(copyBytes[3], 4);
+}
+
+TEST_F(SerializedValueTest, Unsupported) {
+  EngineScope scope(engine);
+
+  auto func = Function::newFunction([]() {});
+  EXPECT_THROW(SerializedValue::serialize(func), Exception);
+
+  auto obj = Object::newObject();
+  obj.set("f", func);
+  EXPECT_THROW(SerializedValue::serialize(obj), Exception);
+
+  // cycle
+  obj = Object::newObject();
+  obj.set("self", obj);
+  EXPECT_THROW(SerializedValue::serialize(obj), Exception);
+
+  EXPECT_THROW(SerializedValue().deserialize(), Exception);
+}
+
+TEST_F(SerializedValueTest, Cycle) {
+  EngineScope scope(engine);
+
+  // each branch reaches the cycle, must not walk every path
+  auto obj = Object::newObject();
+  obj.set("a", obj);
+  obj.set("b", obj);
+  EXPECT_THROW(SerializedValue::serialize(obj), Exception);
+
+  auto list = Array::newArray();
+  auto inner = Object::newObject();
+  inner.set("list", list);
+  list.add(inner);
+  list.add(inner);
+  EXPECT_THROW(SerializedValue::serialize(list), Exception);
+}
+
+TEST_F(SerializedValueTest, SharedReferences) {
+  EngineScope scope(engine);
+
+  // every level references the one below twice, 2^40 paths if shared values are not written once
+  constexpr int kLevels = 40;
+  Local<Object> value = Object::newObject();
+  value.set("leaf", Number::newNumber(1));
+  for (int i = 0; i < kLevels; ++i) {
+    auto next = Object::newObject();
+    next.set("a", value);
+    next.set("b", value);
+    value = next;
+  }
+
+  auto data = SerializedValue::serialize(value);
+  auto copy = data.deserialize();
+  for (int i = 0; i < kLevels; ++i) {
+    ASSERT_TRUE(copy.isObject());
+    auto a = copy.asObject().get("a");
+    auto b = copy.asObject().get("b");
+    ASSERT_TRUE(a.isObject());
+    EXPECT_TRUE(a == b);
+    copy = a;
+  }
+  ASSERT_TRUE(copy.isObject());
+  EXPECT_EQ(copy.asObject().get("leaf").asNumber().toInt32(), 1);
+
+  // shared, not a cycle
+  auto shared = Array::newArray();
+  shared.add(String::newString("x"));
+  auto list = Array::newArray();
+  list.add(shared);
+  list.add(shared);
+  auto listCopy = SerializedValue::serialize(list).deserialize().asArray();
+  ASSERT_EQ(listCopy.size(), 2);
+  EXPECT_TRUE(listCopy.get(0) == listCopy.get(1));
+  EXPECT_EQ(listCopy.get(0).asArray().get(0).asString().toString(), "x");
+}
+
+#ifndef SCRIPTX_BACKEND_WEBASSEMBLY
+TEST_F(SerializedValueTest, CrossEngine) {
+  SerializedValue data;
+  {
+    EngineScope scope(engine);
+    auto value = engine->eval(TS().js("({answer: 42, text: 'hi'})")
+                                  .lua("return {answer = 42, text = 'hi'}")
+                                  .select());
+    data = SerializedValue::serialize(value);
+  }
+
+  auto other = new ScriptEngineImpl();
+  {
+    EngineScope scope(other);
+    auto obj = data.deserialize().asObject();
+    EXPECT_EQ(obj.get("answer").asNumber().toInt32(), 42);
+    EXPECT_EQ(obj.get("text").asString().toString(), "hi");
+  }
+  other->destroy();
+}
+#endif
+
+}  // namespace script::test
@@ -0,0 +1,89 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2021 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <vector>
+#include "../../src/utils/SizeClassPool.h"
+#include "test.h"
+
+namespace script::utils {
+
+TEST(SizeClassPool, Reuse) {
+  SizeClassPool pool;
+  EXPECT_EQ(pool.allocate(0), nullptr);
+
+  auto a = pool.allocate(24);
+  auto b = pool.allocate(32);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % SizeClassPool::kAlignment, 0);
+  EXPECT_EQ(pool.reservedBytes(), SizeClassPool::kSlabSize);
+
+  // same size class
+  pool.deallocate(a, 24);
+  EXPECT_EQ(pool.allocate(17), a);
+
+  pool.deallocate(a, 17);
+  pool.deallocate(b, 32);
+}
+
+TEST(SizeClassPool, Large) {
+  SizeClassPool pool;
+  auto size = SizeClassPool::kMaxSmallSize + 1;
+  auto p = pool.allocate(size);
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(pool.reservedBytes(), size);
+  pool.deallocate(p, size);
+  EXPECT_EQ(pool.reservedBytes(), 0);
+}
+
+TEST(SizeClassPool, Reallocate) {
+  SizeClassPool pool;
+  auto p = static_cast<char*>(pool.allocate(8));
+  std::memcpy(p, "scriptx", 8);
+
+  // grow within size class, across size classes, then to malloc and back
+  size_t current = 8;
+  for (size_t size : {16u, 100u, 1000u, 100000u, 64u}) {
+    p = static_cast<char*>(pool.reallocate(p, current, size));
+    ASSERT_NE(p, nullptr);
+    EXPECT_STREQ(p, "scriptx");
+    current = size;
+  }
+
+  EXPECT_EQ(pool.reallocate(p, current, 0), nullptr);
+}
+
+TEST(SizeClassPool, ManyBlocks) {
+  SizeClassPool pool;
+  std::vector<std::pair<char*, size_t>> blocks;
+  for (size_t i = 0; i < 10000; ++i) {
+    auto size = 1 + i % SizeClassPool::kMaxSmallSize;
+    auto p = static_cast<char*>(pool.allocate(size));
+    ASSERT_NE(p, nullptr);
+    std::memset(p, static_cast<int>(i & 0xff), size);
+    blocks.emplace_back(p, size);
+  }
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    auto [p, size] = blocks[i];
+    EXPECT_EQ(static_cast<unsigned char>(p[size - 1]), i & 0xff);
+    pool.deallocate(p, size);
+  }
+}
+
+}  // namespace script::utils
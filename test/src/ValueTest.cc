@@ -527,6 +527,31 @@ TEST_F(ValueTest, Array) {
   EXPECT_EQ(arr.get(0).asNumber().toInt32(), 42);
 }
 
+TEST_F(ValueTest, ArrayRange) {
+  EngineScope engineScope(engine);
+  std::vector<Local<Value>> elements{Number::newNumber(0), Number::newNumber(1),
+                                     Number::newNumber(2)};
+  auto arr = Array::newArray(elements.data(), elements.size());
+  EXPECT_EQ(arr.size(), 3);
+
+  arr.addRange({String::newString("hello"), ::script::Boolean::newBoolean(true)});
+  EXPECT_EQ(arr.size(), 5);
+
+  auto range = arr.getRange(1, 4);
+  ASSERT_EQ(range.size(), 4);
+  EXPECT_EQ(range[0].asNumber().toInt32(), 1);
+  EXPECT_EQ(range[1].asNumber().toInt32(), 2);
+  EXPECT_STREQ(range[2].asString().toString().c_str(), "hello");
+  EXPECT_TRUE(range[3].asBoolean().value());
+
+  arr.setRange(0, {Number::newNumber(42), Number::newNumber(43)});
+  Local<Value> head[2];
+  arr.getRange(0, 2, head);
+  EXPECT_EQ(head[0].asNumber().toInt32(), 42);
+  EXPECT_EQ(head[1].asNumber().toInt32(), 43);
+  EXPECT_EQ(arr.size(), 5);
+}
+
 TEST_F(ValueTest, Null) {
   EngineScope engineScope(engine);
 
@@ -66,6 +66,13 @@ class ScriptXTestFixture : public testing::Test {
   void TearDown() override;
 
   void destroyEngine();
+
+#ifdef SCRIPTX_BACKEND_LUA
+  // weak ids handed out by the Lua backend, freed ids are reused
+  size_t luaWeakIdCount() const {
+    return static_cast<lua_backend::LuaEngine*>(engine)->weakIdCounter_;
+  }
+#endif
 };
 }  // namespace script::test
 